@@ -38,143 +38,143 @@ __FBSDID("$FreeBSD$");
 
 #define AS_DEBUG 0
 
-/* Marker for the current file offset(s). */
-static int offset = 0;
-static int line = 0;
-
 /* Forward declarations. */
-static int as_skip_whitespaces (FILE *fp);
-inline int as_skip_strings (FILE *fp, int delim);
-static int as_check_valid_section (char *name);
-static int as_check_keyword (char *name);
-static bool_t as_is_function_call (char *name);
-static char* as_get_name (FILE *fp, int ch);
-static int as_get_next_token (graph_t *graph, FILE *fp, char **name);
+static int as_skip_whitespaces (lexer_t *lex);
+static inline int as_skip_strings (lexer_t *lex, int delim);
+static inline bool_t as_name_equals (const char *name, size_t len,
+                                     const char *str);
+static int as_check_valid_section (const char *name, size_t len);
+static int as_check_keyword (const char *name, size_t len);
+static bool_t as_is_function_call (const char *name, size_t len);
+static const char* as_get_name (source_t *src, size_t *len);
+static int as_get_next_token (lexer_t *lex, const char **name,
+                              size_t *namelen);
 
 /**
  * Skips whitespaces, tabs and comments within a file buffer.
  *
- * \param fp The file to read and skip the whitespaces from.
+ * \param lex The lexer to read and skip the whitespaces for.
  * \return The character value or EOF, if the end of the file was reached.
  */
 static int
-as_skip_whitespaces (FILE *fp)
+as_skip_whitespaces (lexer_t *lex)
 {
+    source_t *src = lex->src;
     int ch;
     int next;
 
-    if (feof (fp))
-        return EOF;
-
-    do
+    while ((ch = source_getc (src)) != EOF)
     {
-        ch = fgetc (fp);
-
         if (isspace (ch))
         {
             if (ch == '\n')
-            {
-                line++; /* new line, increase line marker. */
-                offset = 0;
-            }
+                lex->line++; /* new line, increase line marker. */
+            /* Skip the rest of longer runs at once. */
+            if (src->cur < src->end && isspace ((unsigned char) *src->cur))
+                src->cur = scan_spaces (src->cur, src->end, &lex->line);
         }
         else if (ch == '/')
         {
             /* Possible comment block. */
-            next = fgetc (fp);
-            offset++;
+            next = source_getc (src);
             if (next == '/')
             {
                 /* Single line comment, skip until a newline. */
-                while (next != '\n' && next != EOF)
+                const char *p = memchr (src->cur, '\n',
+                    (size_t) (src->end - src->cur));
+                if (!p)
                 {
-                    next = fgetc (fp);
-                    offset++;
-                }
-
-                if (next == EOF)
+                    src->cur = src->end;
                     return EOF;
-                    
-                /* Line increment. */
-                offset = 1;
-                line++;
+                }
 
-                ch = fgetc (fp);
+                /* Line increment. The character following the newline
+                 * is skipped as well. */
+                src->cur = p + 1;
+                lex->line++;
+                source_getc (src);
             }
             else if (next == '*')
             {
                 /* Multiline comment, skip anything until we reached
                  * its end. */
-                while (ch != '*' || next != '/')
+                const char *p = scan_comment (src->cur - 1, src->end,
+                    &lex->line);
+                if (!p)
                 {
-                    ch = next;
-                    next = fgetc (fp);
-                    if (next == EOF)
-                        return EOF;
-                    offset++;
-
-                    if (next == '\n')
-                    {
-                        offset = 0;
-                        line++;
-                    }
+                    src->cur = src->end;
+                    return EOF;
                 }
+                src->cur = p;
             }
             else
             {
-                ungetc (next, fp);
+                source_ungetc (src, next);
                 return ch;
             }
         } /* if (ch == '/') */
         else
             return ch;
     }
-    while (!feof (fp));
     return EOF;
 }
 
 /**
  * Skips characters until the certain delimiter is reached.
  *
- * \param fp The file to read and skip the strings from.
+ * \param lex The lexer to read and skip the strings for.
  * \param delim The delimiter character.
  * \return The next character after the delimiter or EOF.
  */
-inline int
-as_skip_strings (FILE *fp, int delim)
+static inline int
+as_skip_strings (lexer_t *lex, int delim)
 {
-    int ch = '\0';
-     
-    while (ch != EOF && ch != delim)
+    source_t *src = lex->src;
+    int ch;
+
+    do
     {
+        /* Find the delimiter or the next escaped character. */
+        src->cur = scan_string (src->cur, src->end, delim, &lex->line);
+        ch = source_getc (src);
         if (ch == '\\')
-            ch = fgetc (fp);
-        ch = fgetc (fp);
-        if (ch == '\n')
-        {
-            line++;
-            offset = 0;
-        }
-        offset++;
+            source_getc (src); /* Skip the escaped character. */
     }
+    while (ch != EOF && ch != delim);
     return ch;
 }
 
+/**
+ * Checks whether a name, that is not NUL-terminated, equals the passed
+ * string.
+ *
+ * \param name The name to check.
+ * \param len The length of the name.
+ * \param str The NUL-terminated string to compare the name with.
+ * \return TRUE, if both are equal, FALSE otherwise.
+ */
+static inline bool_t
+as_name_equals (const char *name, size_t len, const char *str)
+{
+    return strncmp (str, name, len) == 0 && str[len] == '\0';
+}
+
 /**
  * Checks, whether the name matches a valid section identifier.
  *
  * \param name The name to check.
+ * \param len The length of the name.
  * \return VAR_SECTION or CMD_SECTION, if the name matches, UNKNOWN, if
  *         not.
  */
 static int
-as_check_valid_section (char *name)
+as_check_valid_section (const char *name, size_t len)
 {
-    if (strcmp (name, ".bss") == 0)
+    if (as_name_equals (name, len, ".bss"))
         return VAR_SECTION;
-    if (strcmp (name, ".data") == 0)
+    if (as_name_equals (name, len, ".data"))
         return VAR_SECTION;
-    if (strcmp (name, ".text") == 0)
+    if (as_name_equals (name, len, ".text"))
         return CMD_SECTION;
     return UNKNOWN;
 }
@@ -183,17 +183,19 @@ as_check_valid_section (char *name)
  * Checks, whether the name is a relevant keyword.
  *
  * \param name The name to check.
+ * \param len The length of the name.
  * \return SECTION, GLOBAL or EXTERN, or UNKNOWN if name is not relevant.
  */
 static int
-as_check_keyword (char *name)
+as_check_keyword (const char *name, size_t len)
 {
-    if (strcmp (name, ".section") == 0)
+    if (as_name_equals (name, len, ".section"))
         return SECTION;
-    if (strcmp (name, ".global") == 0 || strcmp (name, ".globl") == 0)
+    if (as_name_equals (name, len, ".global") ||
+        as_name_equals (name, len, ".globl"))
         return GLOBAL;
     /* Superfluous */
-    if (strcmp (name, ".extern") == 0)
+    if (as_name_equals (name, len, ".extern"))
         return EXTERN;
     return UNKNOWN;
 }
@@ -202,77 +204,55 @@ as_check_keyword (char *name)
  * Checks, whether the name is a valid function call identifier.
  *
  * \param name The name to check.
+ * \param len The length of the name.
  * \return TRUE, if name is a valid function call identifier, FALSE
  *         otherwise.
  */
 static bool_t
-as_is_function_call (char *name)
+as_is_function_call (const char *name, size_t len)
 {
-    return strcmp (name, "call") == 0;
+    return as_name_equals (name, len, "call");
 }
 
 /**
- * Reads and returns a name. The return value has to be freed by the
- * caller.
+ * Reads a name. The name is not copied, but returned as a pointer into
+ * the source, which is valid as long as the source is.
  * 
- * \param fp The file to read the name from.
- * \param ch The character to start with.
- * \return A valid C identifier name.
+ * \param src The source to read the name from. Its first character
+ *        must have been read already.
+ * \param len Receives the length of the name.
+ * \return The start of the name within the source.
  */
-static char*
-as_get_name (FILE *fp, int ch)
+static const char*
+as_get_name (source_t *src, size_t *len)
 {
-    char *name = NULL;
-    char *tmp = NULL;
-    int i = 0;
-
-    name = malloc (sizeof (char));
-    if (!name)
-        return NULL;
-    name[0] = '\0';
-
-    do
-    {
-        tmp = realloc (name, sizeof (char) * (i + 2));
-        if (!tmp)
-        {
-            if (name)
-                free (name);
-            return NULL;
-        }
-        name = tmp;
-        name[i] = ch;
-        name[i + 1] = '\0';
-        i++;
-
-        ch = fgetc (fp);
-        if (ch == EOF)
-        {
-            free (name);
-            return NULL;
-        }
-        offset++;
-    }
-    while (isalnum (ch) || ch == '_');
-    ungetc (ch, fp); /* Unget the last one. It's not the name. */
-    return name;
+    const char *start = src->cur - 1;
+    const char *p = src->cur;
+
+    while (p < src->end && (isalnum ((unsigned char) *p) || *p == '_'))
+        p++;
+    src->cur = p;
+    *len = (size_t) (p - start);
+    return start;
 }
 
 /**
  * Gets the next valid token type from the file.
  *
- * \param graph The graph to get the next token for.
- * \param fp The file to get the next token from.
+ * \param lex The lexer to get the next token for.
+ * \param name Receives the start of the last name within the source.
+ * \param namelen Receives the length of the last name.
  * \return An enum value indicating the type of token.
  */
 static int
-as_get_next_token (graph_t *graph, FILE *fp, char **name)
+as_get_next_token (lexer_t *lex, const char **name, size_t *namelen)
 {
+    source_t *src = lex->src;
     int ch;
 
     do
     {
-        ch = as_skip_whitespaces (fp);
+        ch = as_skip_whitespaces (lex);
         switch (ch)
         {
         case EOF:
@@ -280,25 +260,23 @@ as_get_next_token (graph_t *graph, FILE *fp, char **name)
         case '"':
         case '\'':
             /* Skip string or char literals. */
-            ch = as_skip_strings (fp, ch);
+            ch = as_skip_strings (lex, ch);
             if (ch == EOF)
                 return ENDOFFILE;
-            return as_get_next_token (graph, fp, name);
+            return as_get_next_token (lex, name, namelen);
         case '.':
         {
             /* A possible section name or local label */
             int token = UNKNOWN;
-            if (*name)
-                free (*name);
-            *name = as_get_name (fp, ch);
+            *name = as_get_name (src, namelen);
             
             /* check for .bss, .data, .text */
-            token = as_check_valid_section (*name);
+            token = as_check_valid_section (*name, *namelen);
             if (token != UNKNOWN)
                 return token;
 
             /* Check for .section, .global, .globl, .extern */
-            token = as_check_keyword (*name);
+            token = as_check_keyword (*name, *namelen);
             if (token != UNKNOWN)
                 return token;
 
@@ -309,23 +287,20 @@ as_get_next_token (graph_t *graph, FILE *fp, char **name)
             if (isalpha (ch) || ch == '_')
             {
                 /* [A-Z] or _ are allowed values for a name identifier. */
-                if (*name)
-                    free (*name);
-
-                *name = as_get_name (fp, ch);
+                *name = as_get_name (src, namelen);
                 
                 /* Check for call instructions. */
-                if (as_is_function_call (*name))
+                if (as_is_function_call (*name, *namelen))
                     return CALL;
 
                 /* Check for a label. */
-                ch = fgetc (fp);
+                ch = source_getc (src);
                 if (ch == EOF)
                     return ENDOFFILE;
                 if (ch == ':')
                     return LABEL;
 
-                ungetc (ch, fp);
+                source_ungetc (src, ch);
 
                 return IDENTIFIER;
             }
@@ -336,27 +311,39 @@ as_get_next_token (graph_t *graph, FILE *fp, char **name)
 }
 
 /**
- * Creates the output graph from the passed graph object.
+ * Records the operations for the graph of a GNU as source in a log.
  *
- * \param graph The graph object to create the output grah for.
- * \return TRUE on success, FALSE on error.
+ * \param log The oplog_t to record the operations in.
+ * \param src The source to scan.
+ * \return TRUE on success, FALSE on error. In case of an error, the
+ *         error message of the log is set.
  */
 bool_t
-as_lex_create_graph (graph_t *graph, FILE *fp, char *filename)
+as_lex_create_log (oplog_t *log, source_t *src)
 {
-    char *curname = NULL; 
-    char *curfunc = NULL;
+    lexer_t lex;             /* State of the lexer. */
+    char *curname = NULL;    /* Current name, interned by the log. */
+    char *curfunc = NULL;    /* Current function, interned by the log. */
     NodeType nodetype = FUNCTION;
-    char *name = NULL;       /* The current node name. */
+    const char *name = NULL; /* The current node name within the source. */
+    size_t namelen = 0;      /* Length of the current node name. */
     int prev = SEMICOLON;    /* Previous token. */
     int token = SEMICOLON;   /* Current token. */
     int funcline = -1;
 
-    line = 1;
-    
+    lex.src = src;
+    lex.log = log;
+    lex.line = 1;
+    lex.field = 0;
+    lex.excludes = 0;
+
     while (prev = token,
-        (token = as_get_next_token (graph, fp, &name)) != ENDOFFILE)
+        (token = as_get_next_token (&lex, &name, &namelen)) != ENDOFFILE)
     {
+        log->tokens++;
+        if (token == IDENTIFIER)
+            log->identifiers++;
+
         /* SECTION .XXXX: ... */
         if (token == SECTION)
         {
@@ -376,10 +363,14 @@ as_lex_create_graph (graph_t *graph, FILE *fp, char *filename)
 
         if (nodetype == VARIABLE && token == LABEL)
         {
-            if (!add_g_node (graph, VARIABLE, name, NULL, filename, line))
+            char *iname = strtab_intern_len (&log->strings, name, namelen);
+            if (!iname)
+                goto memerror;
+            if (!oplog_add (log, OP_DEFINE, VARIABLE, iname, NULL, lex.line,
+                    -1))
                 goto memerror;
 #if AS_DEBUG
-                printf ("Adding variable declaration %s\n", name);
+                printf ("Adding variable declaration %s\n", iname);
 #endif
         }
 
@@ -393,9 +384,7 @@ as_lex_create_graph (graph_t *graph, FILE *fp, char *filename)
             /* Copy the function name. */
             if (name)
             {
-                if (curname)
-                    free (curname);
-                curname = strdup (name);
+                curname = strtab_intern_len (&log->strings, name, namelen);
                 if (!curname)
                     goto memerror;
             }
@@ -404,82 +393,87 @@ as_lex_create_graph (graph_t *graph, FILE *fp, char *filename)
         if (prev == IDENTIFIER && token == LABEL)
         {
             /* NAME: */
-            if (curname && strcmp (curname, name) == 0)
+            if (curname && as_name_equals (name, namelen, curname))
             {
                 /*       global NAME
                  * NAME:
                  * We seem to be in the correct function.
                  */
-                funcline = line;
-                if (!add_g_node (graph, FUNCTION, curname, NULL, filename,
-                                 line))
+                funcline = lex.line;
+                if (!oplog_add (log, OP_DEFINE, FUNCTION, curname, NULL,
+                        lex.line, -1))
                     goto memerror;
 #if AS_DEBUG
                 printf ("Adding function declaration %s\n", curname);
 #endif
-                if (curfunc)
-                    free (curfunc);
-
-                curfunc = strdup (curname);
-                if (!curfunc)
-                    goto memerror;
-                free (curname);
+                curfunc = curname;
                 curname = NULL;
             }
         }
 
         if (prev == CALL && token == IDENTIFIER && curfunc != NULL)
         {
-            /* Function call. */
-            g_subnode_t *sub = NULL;
-            g_node_t *call = get_definition_node (graph->defines, name,
-                                                  filename);
-            if (!call)
-            {
-                call = add_g_node (graph, FUNCTION, name, NULL, filename, -1);
-                if (!call)
-                    goto memerror;
-                call->ntype = FUNCTION;
-            }
-            sub = create_sub_node (call);
-            if (!sub)
+            /* Function call, the call node is created on demand. */
+            char *iname = strtab_intern_len (&log->strings, name, namelen);
+            if (!iname)
+                goto memerror;
+            if (!oplog_add (log, OP_CALL, FUNCTION, iname, NULL, -1, -1) ||
+                !oplog_add (log, OP_FLUSH, FUNCTION, curfunc, NULL, -1, -1))
                 goto memerror;
-            if (!add_to_call_stack (graph, curfunc, filename, sub))
-                goto error;
 #if AS_DEBUG
-                printf ("Adding function call '%s' in func '%s', %d\n", name,
-                        curfunc, line);
+                printf ("Adding function call '%s' in func '%s', %d\n", iname,
+                        curfunc, lex.line);
 #endif
         }
         else if ((prev == IDENTIFIER || prev == COMMA) &&
                  token == IDENTIFIER && curfunc && name)
         {
-            /* Is this a call to a variable? */
-            g_node_t *call = get_definition_node (graph->defines, name,
-                                                  filename);
-            if (call && call->ntype == VARIABLE)
-            {
-                g_subnode_t *sub = create_sub_node (call);
-                if (!sub)
-                    goto memerror;
-                if (!add_to_call_stack (graph, curfunc, filename, sub))
-                    goto error;
+            /* Is this a call to a variable? Once the log is replayed,
+             * global variables are added to the call stack. */
+            char *iname = strtab_intern_len (&log->strings, name, namelen);
+            if (!iname)
+                goto memerror;
+            if (!oplog_add (log, OP_REFERENCE, VARIABLE, iname, NULL, -1,
+                    -1) ||
+                !oplog_add (log, OP_FLUSH, FUNCTION, curfunc, NULL, -1, -1))
+                goto memerror;
 #if AS_DEBUG
-            printf ("Adding global variable call %s\n", name);
+            printf ("Adding global variable call %s\n", iname);
 #endif
-            }
         }
     }
     
-    if (curfunc)
-        free (curfunc);
-    if (name)
-        free (name);
     return TRUE;
 
 memerror:
-    fprintf (stderr, "%s: Memory allocation error for line %d\n", filename,
-        line);
-error:
+    oplog_error (log, "Memory allocation error for line %d", lex.line);
     return FALSE;
 }
+
+/**
+ * Creates the output graph from the passed graph object.
+ *
+ * The source can be a file opened with source_open() or a buffer of
+ * the caller passed to source_init_buffer(). The state of the lexer is
+ * kept on the stack, so that different graphs can be created
+ * concurrently.
+ *
+ * \param graph The graph object to create the output grah for.
+ * \param src The source of the file to create the graph for.
+ * \param filename The name of the file.
+ * \return TRUE on success, FALSE on error.
+ */
+bool_t
+as_lex_create_graph (graph_t *graph, source_t *src, const char *filename)
+{
+    oplog_t log;
+    bool_t retval;
+
+    if (!oplog_init (&log, filename))
+        oplog_error (&log, "Memory allocation error");
+    else
+        as_lex_create_log (&log, src);
+    retval = oplog_replay (graph, &log);
+    oplog_free (&log);
+    return retval;
+}
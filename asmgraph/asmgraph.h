@@ -66,7 +66,11 @@ enum
     AS_LEXER    /* Use the parser for GNU as syntax. */
 };
 
-bool_t nasm_lex_create_graph (graph_t *graph, FILE *fp, char *filename);
-bool_t as_lex_create_graph (graph_t *graph, FILE *fp, char *filename);
+bool_t nasm_lex_create_graph (graph_t *graph, source_t *src,
+                              const char *filename);
+bool_t as_lex_create_graph (graph_t *graph, source_t *src,
+                            const char *filename);
+bool_t nasm_lex_create_log (oplog_t *log, source_t *src);
+bool_t as_lex_create_log (oplog_t *log, source_t *src);
 
 #endif /* ASMGRAPH_H */
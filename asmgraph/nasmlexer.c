@@ -38,113 +38,152 @@ __FBSDID("$FreeBSD$");
 
 #define NASM_DEBUG 0
 
-/* Marker for the current file offset(s). */
-static int offset = 0;
-static int line = 0;
-static int curfield = 0;
-
 /* Forward declarations. */
-static int nasm_skip_whitespaces (FILE *fp);
-inline int nasm_skip_strings (FILE *fp, int delim);
-static int nasm_check_valid_section (char *name);
-static int nasm_check_keyword (char *name);
-static bool_t nasm_is_function_call (char *name);
-static char* nasm_get_name (FILE *fp, int ch);
-static int nasm_get_next_token (graph_t *graph, FILE *fp, char **name);
+static int nasm_skip_whitespaces (lexer_t *lex);
+static inline int nasm_skip_strings (lexer_t *lex, int delim);
+static inline bool_t nasm_name_equals (const char *name, size_t len,
+                                       const char *str);
+static inline bool_t nasm_name_equals_nocase (const char *name, size_t len,
+                                              const char *str);
+static int nasm_check_valid_section (const char *name, size_t len);
+static int nasm_check_keyword (const char *name, size_t len);
+static bool_t nasm_is_function_call (const char *name, size_t len);
+static const char* nasm_get_name (source_t *src, size_t *len);
+static int nasm_get_next_token (lexer_t *lex, const char **name,
+                                size_t *namelen);
 
 /**
  * Skips whitespaces, tabs and comments within a file buffer.
  *
- * \param fp The FILE to read and skip the whitespaces from.
+ * \param lex The lexer to read and skip the whitespaces for.
  * \return The character value or EOF, if the end of the file was reached.
  */
 static int
-nasm_skip_whitespaces (FILE *fp)
+nasm_skip_whitespaces (lexer_t *lex)
 {
+    source_t *src = lex->src;
     int ch;
 
-    if (feof (fp))
-        return EOF;
-
-    do
+    while ((ch = source_getc (src)) != EOF)
     {
-        ch = fgetc (fp);
-
         if (isspace (ch))
         {
             if (ch == '\n')
             {
-                line++; /* new line, increase line marker. */
-                curfield = 0; /* Reset the field indicator. */
-                offset = 0;
+                lex->line++; /* new line, increase line marker. */
+                lex->field = 0; /* Reset the field indicator. */
+            }
+            /* Skip the rest of longer runs at once. */
+            if (src->cur < src->end && isspace ((unsigned char) *src->cur))
+            {
+                int lines = 0;
+
+                src->cur = scan_spaces (src->cur, src->end, &lines);
+                if (lines > 0)
+                {
+                    lex->line += lines;
+                    lex->field = 0;
+                }
             }
         }
         else if (ch == ';')
         {
-            int prev;
-
             /* Skip through comments */
             while (ch != EOF && ch != '\n')
             {
-                prev = ch;
                 if (ch == '\\')
                 {
-                    prev = ch;
-                    ch = fgetc (fp);
-                    line++;
+                    ch = source_getc (src);
+                    lex->line++;
                 }
-                ch = fgetc (fp);
+                ch = source_getc (src);
             }
         }
         else
             return ch;
     }
-    while (!feof (fp));
     return EOF;
 }
 
 /**
  * Skips characters until the certain delimiter is reached.
  *
- * \param fp The file to read and skip the strings from.
+ * \param lex The lexer to read and skip the strings for.
  * \param delim The delimiter character.
  * \return The next character after the delimiter or EOF.
  */
-inline int
-nasm_skip_strings (FILE *fp, int delim)
+static inline int
+nasm_skip_strings (lexer_t *lex, int delim)
 {
-    int ch = '\0';
-     
-    while (ch != EOF && ch != delim)
+    source_t *src = lex->src;
+    int ch;
+
+    do
     {
+        /* Find the delimiter or the next escaped character. */
+        src->cur = scan_string (src->cur, src->end, delim, &lex->line);
+        ch = source_getc (src);
         if (ch == '\\')
-            ch = fgetc (fp);
-        ch = fgetc (fp);
-        if (ch == '\n')
-        {
-            line++;
-            offset = 0;
-        }
-        offset++;
+            source_getc (src); /* Skip the escaped character. */
     }
+    while (ch != EOF && ch != delim);
     return ch;
 }
 
+/**
+ * Checks whether a name, that is not NUL-terminated, equals the passed
+ * string.
+ *
+ * \param name The name to check.
+ * \param len The length of the name.
+ * \param str The NUL-terminated string to compare the name with.
+ * \return TRUE, if both are equal, FALSE otherwise.
+ */
+static inline bool_t
+nasm_name_equals (const char *name, size_t len, const char *str)
+{
+    return strncmp (str, name, len) == 0 && str[len] == '\0';
+}
+
+/**
+ * Checks whether a name, that is not NUL-terminated, equals the passed
+ * string, ignoring the case of both.
+ *
+ * \param name The name to check.
+ * \param len The length of the name.
+ * \param str The NUL-terminated string to compare the name with.
+ * \return TRUE, if both are equal, FALSE otherwise.
+ */
+static inline bool_t
+nasm_name_equals_nocase (const char *name, size_t len, const char *str)
+{
+    size_t i;
+
+    for (i = 0; i < len; i++)
+    {
+        if (str[i] == '\0' || tolower ((unsigned char) str[i]) !=
+            tolower ((unsigned char) name[i]))
+            return FALSE;
+    }
+    return str[len] == '\0';
+}
+
 /**
  * Checks, whether the name matches a valid section identifier.
  *
  * \param name The name to check.
+ * \param len The length of the name.
  * \return VAR_SECTION or CMD_SECTION, if the name matches, UNKNOWN, if
  *         not.
  */
 static int
-nasm_check_valid_section (char *name)
+nasm_check_valid_section (const char *name, size_t len)
 {
-    if (strcasecmp (name, ".bss") == 0)
+    if (nasm_name_equals_nocase (name, len, ".bss"))
         return VAR_SECTION;
-    if (strcasecmp (name, ".data") == 0)
+    if (nasm_name_equals_nocase (name, len, ".data"))
         return VAR_SECTION;
-    if (strcasecmp (name, ".text") == 0)
+    if (nasm_name_equals_nocase (name, len, ".text"))
         return CMD_SECTION;
     return UNKNOWN;
 }
@@ -153,16 +192,17 @@ nasm_check_valid_section (char *name)
  * Checks, whether the name is a relevant keyword.
  *
  * \param name The name to check.
+ * \param len The length of the name.
  * \return SECTION, GLOBAL or EXTERN, or UNKNOWN if name is not relevant.
  */
 static int
-nasm_check_keyword (char *name)
+nasm_check_keyword (const char *name, size_t len)
 {
-    if (strcasecmp (name, "section") == 0)
+    if (nasm_name_equals_nocase (name, len, "section"))
         return SECTION;
-    if (strcasecmp (name, "global") == 0)
+    if (nasm_name_equals_nocase (name, len, "global"))
         return GLOBAL;
-    if (strcasecmp (name, "extern") == 0)
+    if (nasm_name_equals_nocase (name, len, "extern"))
         return EXTERN;
     return UNKNOWN;
 }
@@ -171,78 +211,56 @@ nasm_check_keyword (char *name)
  * Checks, whether the name is a valid function call identifier.
  *
  * \param name The name to check.
+ * \param len The length of the name.
  * \return TRUE, if name is a valid function call identifier, FALSE
  *         otherwise.
  */
 static bool_t
-nasm_is_function_call (char *name)
+nasm_is_function_call (const char *name, size_t len)
 {
-    return strcasecmp (name, "call") == 0;
+    return nasm_name_equals_nocase (name, len, "call");
 }
 
 /**
- * Reads and returns a name. The return value has to be freed by the
- * caller.
+ * Reads a name. The name is not copied, but returned as a pointer into
+ * the source, which is valid as long as the source is.
  * 
- * \param fp The file to read the name from.
- * \param ch The character to start with.
- * \return A valid C identifier name.
+ * \param src The source to read the name from. Its first character
+ *        must have been read already.
+ * \param len Receives the length of the name.
+ * \return The start of the name within the source.
  */
-static char*
-nasm_get_name (FILE *fp, int ch)
+static const char*
+nasm_get_name (source_t *src, size_t *len)
 {
-    char *name = NULL;
-    char *tmp = NULL;
-    int i = 0;
-
-    name = malloc (sizeof (char));
-    if (!name)
-        return NULL;
-    name[0] = '\0';
-
-    do
-    {
-        tmp = realloc (name, sizeof (char) * (i + 2));
-        if (!tmp)
-        {
-            if (name)
-                free (name);
-            return NULL;
-        }
-        name = tmp;
-        name[i] = ch;
-        name[i + 1] = '\0';
-        i++;
-
-        ch = fgetc (fp);
-        if (ch == EOF)
-        {
-            free (name);
-            return NULL;
-        }
-        offset++;
-    }
-    while (isalnum (ch) || ch == '_');
-    ungetc (ch, fp); /* Unget the last one. It's not the name. */
-    return name;
+    const char *start = src->cur - 1;
+    const char *p = src->cur;
+
+    while (p < src->end && (isalnum ((unsigned char) *p) || *p == '_'))
+        p++;
+    src->cur = p;
+    *len = (size_t) (p - start);
+    return start;
 }
 
 /**
  * Gets the next valid token type from the file.
  *
- * \param graph The graph to get the next token for.
- * \param fp The file to get the next token from.
+ * \param lex The lexer to get the next token for.
+ * \param name Receives the start of the last name within the source.
+ * \param namelen Receives the length of the last name.
  * \return An enum value indicating the type of token.
  */
 static int
-nasm_get_next_token (graph_t *graph, FILE *fp, char **name)
+nasm_get_next_token (lexer_t *lex, const char **name, size_t *namelen)
 {
+    source_t *src = lex->src;
     int ch;
 
     do
     {
-        curfield++;
-        ch = nasm_skip_whitespaces (fp);
+        lex->field++;
+        ch = nasm_skip_whitespaces (lex);
         switch (ch)
         {
         case EOF:
@@ -250,20 +268,18 @@ nasm_get_next_token (graph_t *graph, FILE *fp, char **name)
         case '"':
         case '\'':
             /* Skip string or char literals. */
-            ch = nasm_skip_strings (fp, ch);
+            ch = nasm_skip_strings (lex, ch);
             if (ch == EOF)
                 return ENDOFFILE;
-            return nasm_get_next_token (graph, fp, name);
+            return nasm_get_next_token (lex, name, namelen);
         case '.':
         {
             /* A possible section name or local label */
             int token = UNKNOWN;
-            if (*name)
-                free (*name);
-            *name = nasm_get_name (fp, ch);
+            *name = nasm_get_name (src, namelen);
             
             /* check for .bss, .data, .text */
-            token = nasm_check_valid_section (*name);
+            token = nasm_check_valid_section (*name, *namelen);
             if (token != UNKNOWN)
                 return token;
             
@@ -275,29 +291,26 @@ nasm_get_next_token (graph_t *graph, FILE *fp, char **name)
             {
                 /* [A-Z] or _ are allowed values for a name identifier. */
                 int token = UNKNOWN;
-                if (*name)
-                    free (*name);
-
-                *name = nasm_get_name (fp, ch);
+                *name = nasm_get_name (src, namelen);
                 
                 /* Check for section, global, extern */
-                token = nasm_check_keyword (*name);
+                token = nasm_check_keyword (*name, *namelen);
                 if (token != UNKNOWN)
                     return token;
 
                 /* Check for call instructions. */
-                if (nasm_is_function_call (*name))
+                if (nasm_is_function_call (*name, *namelen))
                     return CALL;
 
                 /* Check for a label. */
-                ch = fgetc (fp);
+                ch = source_getc (src);
                 if (ch == EOF)
                     return ENDOFFILE;
                 if (ch == ':')
                     return LABEL;
-                ungetc (ch, fp);
+                source_ungetc (src, ch);
 
-                if (curfield == 0)
+                if (lex->field == 0)
                     return LABEL;
 
                 return IDENTIFIER;
@@ -309,23 +322,31 @@ nasm_get_next_token (graph_t *graph, FILE *fp, char **name)
 }
 
 /**
- * Creates the output graph from the passed graph object.
+ * Records the operations for the graph of a NASM source in a log.
  *
- * \param graph The graph object to create the output grah for.
- * \return TRUE on success, FALSE on error.
+ * \param log The oplog_t to record the operations in.
+ * \param src The source to scan.
+ * \return TRUE on success, FALSE on error. In case of an error, the
+ *         error message of the log is set.
  */
 bool_t
-nasm_lex_create_graph (graph_t *graph, FILE *fp, char *filename)
+nasm_lex_create_log (oplog_t *log, source_t *src)
 {
-    char *curname = NULL; 
-    char *curfunc = NULL;
+    lexer_t lex;             /* State of the lexer. */
+    char *curname = NULL;    /* Current name, interned by the log. */
+    char *curfunc = NULL;    /* Current function, interned by the log. */
     NodeType nodetype = FUNCTION;
-    char *name = NULL;       /* The current node name. */
+    const char *name = NULL; /* The current node name within the source. */
+    size_t namelen = 0;      /* Length of the current node name. */
     int prev = SEMICOLON;    /* Previous token. */
     int token = SEMICOLON;   /* Current token. */
     int funcline = -1;
 
-    line = 1;
+    lex.src = src;
+    lex.log = log;
+    lex.line = 1;
+    lex.field = 0;
+    lex.excludes = 0;
 
     /* nasm uses a variable 4-field syntax:
      *
@@ -335,8 +356,12 @@ nasm_lex_create_graph (graph_t *graph, FILE *fp, char *filename)
      * about the line breaks of a physical line.
      */
     while (prev = token,
-        (token = nasm_get_next_token (graph, fp, &name)) != ENDOFFILE)
+        (token = nasm_get_next_token (&lex, &name, &namelen)) != ENDOFFILE)
     {
+        log->tokens++;
+        if (token == IDENTIFIER)
+            log->identifiers++;
+
         /* SECTION .XXXX: ... */
         if (token == SECTION)
         {
@@ -356,10 +381,14 @@ nasm_lex_create_graph (graph_t *graph, FILE *fp, char *filename)
 
         if (nodetype == VARIABLE && token == LABEL)
         {
-            if (!add_g_node (graph, VARIABLE, name, NULL, filename, line))
+            char *iname = strtab_intern_len (&log->strings, name, namelen);
+            if (!iname)
+                goto memerror;
+            if (!oplog_add (log, OP_DEFINE, VARIABLE, iname, NULL, lex.line,
+                    -1))
                 goto memerror;
 #if NASM_DEBUG
-                printf ("Adding variable declaration %s\n", name);
+                printf ("Adding variable declaration %s\n", iname);
 #endif
         }
 
@@ -373,9 +402,7 @@ nasm_lex_create_graph (graph_t *graph, FILE *fp, char *filename)
             /* Copy the function name. */
             if (name)
             {
-                if (curname)
-                    free (curname);
-                curname = strdup (name);
+                curname = strtab_intern_len (&log->strings, name, namelen);
                 if (!curname)
                     goto memerror;
             }
@@ -384,83 +411,87 @@ nasm_lex_create_graph (graph_t *graph, FILE *fp, char *filename)
         if (prev == IDENTIFIER && token == LABEL)
         {
             /* NAME: */
-            if (curname && strcmp (curname, name) == 0)
+            if (curname && nasm_name_equals (name, namelen, curname))
             {
                 /*       global NAME
                  * NAME:
                  * We seem to be in the correct function.
                  */
-                funcline = line;
-                if (!add_g_node (graph, FUNCTION, curname, NULL, filename,
-                        line))
+                funcline = lex.line;
+                if (!oplog_add (log, OP_DEFINE, FUNCTION, curname, NULL,
+                        lex.line, -1))
                     goto memerror;
 #if NASM_DEBUG
                 printf ("Adding function declaration %s\n", curname);
 #endif
-                if (curfunc)
-                    free (curfunc);
-
-                curfunc = strdup (curname);
-                if (!curfunc)
-                    goto memerror;
-                free (curname);
+                curfunc = curname;
                 curname = NULL;
             }
         }
 
         if (prev == CALL && token == IDENTIFIER && curfunc != NULL)
         {
-            /* Function call. */
-            g_subnode_t *sub = NULL;
-            g_node_t *call = get_definition_node (graph->defines, name,
-                                                  filename);
-            if (!call)
-            {
-                call = add_g_node (graph, FUNCTION, name, NULL, filename, -1);
-                if (!call)
-                    goto memerror;
-                call->ntype = FUNCTION;
-            }
-            sub = create_sub_node (call);
-            if (!sub)
+            /* Function call, the call node is created on demand. */
+            char *iname = strtab_intern_len (&log->strings, name, namelen);
+            if (!iname)
+                goto memerror;
+            if (!oplog_add (log, OP_CALL, FUNCTION, iname, NULL, -1, -1) ||
+                !oplog_add (log, OP_FLUSH, FUNCTION, curfunc, NULL, -1, -1))
                 goto memerror;
-            if (!add_to_call_stack (graph, curfunc, filename, sub))
-                goto error;
 #if NASM_DEBUG
-                printf ("Adding function call '%s' in func '%s', %d\n", name,
-                        curfunc, line);
+                printf ("Adding function call '%s' in func '%s', %d\n", iname,
+                        curfunc, lex.line);
 #endif
         }
         else if ((prev == IDENTIFIER || prev == COMMA) &&
                  token == IDENTIFIER && curfunc && name)
         {
-            /* Is this a call to a variable? */
-            g_node_t *call = get_definition_node (graph->defines, name,
-                                                  filename);
-            if (call && call->ntype == VARIABLE)
-            {
-                g_subnode_t *sub = create_sub_node (call);
-                if (!sub)
-                    goto memerror;
-                if (!add_to_call_stack (graph, curfunc, filename, sub))
-                    goto error;
+            /* Is this a call to a variable? Once the log is replayed,
+             * global variables are added to the call stack. */
+            char *iname = strtab_intern_len (&log->strings, name, namelen);
+            if (!iname)
+                goto memerror;
+            if (!oplog_add (log, OP_REFERENCE, VARIABLE, iname, NULL, -1,
+                    -1) ||
+                !oplog_add (log, OP_FLUSH, FUNCTION, curfunc, NULL, -1, -1))
+                goto memerror;
 #if NASM_DEBUG
-            printf ("Adding global variable call %s\n", name);
+            printf ("Adding global variable call %s\n", iname);
 #endif
-            }
         }
     }
     
-    if (curfunc)
-        free (curfunc);
-    if (name)
-        free (name);
-
     return TRUE;
 
 memerror:
-    fprintf (stderr, "%s: Memory allocation error for line %d\n", filename,
-        line);
-error:
+    oplog_error (log, "Memory allocation error for line %d", lex.line);
     return FALSE;
 }
+
+/**
+ * Creates the output graph from the passed graph object.
+ *
+ * The source can be a file opened with source_open() or a buffer of
+ * the caller passed to source_init_buffer(). The state of the lexer is
+ * kept on the stack, so that different graphs can be created
+ * concurrently.
+ *
+ * \param graph The graph object to create the output grah for.
+ * \param src The source of the file to create the graph for.
+ * \param filename The name of the file.
+ * \return TRUE on success, FALSE on error.
+ */
+bool_t
+nasm_lex_create_graph (graph_t *graph, source_t *src, const char *filename)
+{
+    oplog_t log;
+    bool_t retval;
+
+    if (!oplog_init (&log, filename))
+        oplog_error (&log, "Memory allocation error");
+    else
+        nasm_lex_create_log (&log, src);
+    retval = oplog_replay (graph, &log);
+    oplog_free (&log);
+    return retval;
+}
@@ -0,0 +1,570 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+/* The lexer is included, so that its static scanning functions can be
+ * measured on their own. */
+#include "clexer.c"
+
+/* Default amount of warm-up and measured runs of each benchmark. */
+#define BENCH_WARMUP 3
+#define BENCH_RUNS 20
+
+/* Inputs and the graph shared by the benchmarks. */
+typedef struct _benchdata
+{
+    char      **files;    /* The names of the input files. */
+    source_t   *srcs;     /* The contents of the input files. */
+    int         count;    /* Amount of input files. */
+    graph_t     graph;    /* The graph created from the files. */
+    char      **misses;   /* Names, which are not in the graph. */
+    graph_t     edges;    /* Graph to add the calls to. */
+    g_node_t  **targets;  /* Nodes of the edge graph by the node ids. */
+    size_t      lines;    /* Amount of lines of the printed graph. */
+    int         devnull;  /* File descriptor to print to. */
+} benchdata_t;
+
+/* A single benchmark. The setup and teardown functions are optional and
+ * are not measured.
+ */
+typedef struct _bench
+{
+    const char *name;     /* Name of the benchmark. */
+    const char *unit;     /* Unit of the processed items. */
+    bool_t    (*setup) (benchdata_t *data);
+    size_t    (*run) (benchdata_t *data);
+    void      (*teardown) (benchdata_t *data);
+} bench_t;
+
+static void usage (void);
+static bool_t lex_file (oplog_t *log, source_t *src, void *data);
+static int compare_times (const void *a, const void *b);
+static double percentile (const double *times, int count, int pct);
+static size_t run_whitespace (benchdata_t *data);
+static size_t run_tokens (benchdata_t *data);
+static size_t run_lexer (benchdata_t *data);
+static size_t run_lookup (benchdata_t *data);
+static size_t run_lookup_miss (benchdata_t *data);
+static bool_t setup_edges (benchdata_t *data);
+static size_t run_edges (benchdata_t *data);
+static void teardown_edges (benchdata_t *data);
+static size_t run_print (benchdata_t *data);
+static bool_t prepare (benchdata_t *data, char **files, int count);
+static bool_t run_bench (const bench_t *bench, benchdata_t *data,
+                         int warmup, int runs);
+
+static const bench_t benches[] =
+{
+    { "whitespace", "bytes", NULL, run_whitespace, NULL },
+    { "tokens", "tokens", NULL, run_tokens, NULL },
+    { "lexer", "tokens", NULL, run_lexer, NULL },
+    { "lookup", "lookups", NULL, run_lookup, NULL },
+    { "lookup-miss", "lookups", NULL, run_lookup_miss, NULL },
+    { "edges", "edges", setup_edges, run_edges, teardown_edges },
+    { "print", "lines", NULL, run_print, NULL },
+    { NULL, NULL, NULL, NULL, NULL }
+};
+
+/**
+ * Displays the usage command of the application.
+ */
+static void
+usage (void)
+{
+    fprintf (stderr,
+        "usage: microbench [-b bench] [-n runs] [-w warmup] file ...\n");
+    exit (EXIT_FAILURE);
+}
+
+/**
+ * Lexer function for create_graph().
+ *
+ * \param log The oplog_t to record the operations in.
+ * \param src The source to scan.
+ * \param data Unused.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+lex_file (oplog_t *log, source_t *src, void *data)
+{
+    (void) data;
+    return lex_create_log (log, src, 0);
+}
+
+/**
+ * Compares two run times for qsort().
+ *
+ * \param a The first time.
+ * \param b The second time.
+ * \return An integer less than, equal to or greater than 0.
+ */
+static int
+compare_times (const void *a, const void *b)
+{
+    double ta = *(const double*) a;
+    double tb = *(const double*) b;
+
+    return (ta > tb) - (ta < tb);
+}
+
+/**
+ * Gets a percentile of sorted run times using the nearest rank.
+ *
+ * \param times The sorted run times.
+ * \param count The amount of run times.
+ * \param pct The percentile to get.
+ * \return The run time of the percentile.
+ */
+static double
+percentile (const double *times, int count, int pct)
+{
+    int rank = (count * pct + 99) / 100;
+
+    if (rank < 1)
+        rank = 1;
+    return times[rank - 1];
+}
+
+/**
+ * Skips the whitespace and comments of the inputs with
+ * skip_whitespaces().
+ *
+ * \param data The benchdata_t to use.
+ * \return The amount of scanned bytes.
+ */
+static size_t
+run_whitespace (benchdata_t *data)
+{
+    source_t src;
+    lexer_t lex;
+    size_t bytes = 0;
+    int i;
+
+    for (i = 0; i < data->count; i++)
+    {
+        source_init_buffer (&src, data->srcs[i].data, data->srcs[i].len);
+        lex.src = &src;
+        lex.line = 1;
+        while (skip_whitespaces (&lex) != EOF)
+            ;
+        bytes += src.len;
+    }
+    return bytes;
+}
+
+/**
+ * Reads the tokens of the inputs with get_next_token().
+ *
+ * \param data The benchdata_t to use.
+ * \return The amount of read tokens.
+ */
+static size_t
+run_tokens (benchdata_t *data)
+{
+    source_t src;
+    lexer_t lex;
+    const char *name;
+    size_t namelen;
+    size_t tokens = 0;
+    int i;
+
+    for (i = 0; i < data->count; i++)
+    {
+        source_init_buffer (&src, data->srcs[i].data, data->srcs[i].len);
+        lex.src = &src;
+        lex.line = 1;
+        lex.excludes = 0;
+        while (get_next_token (&lex, &name, &namelen) != ENDOFFILE)
+            tokens++;
+    }
+    return tokens;
+}
+
+/**
+ * Records the operations of the inputs with lex_create_log().
+ *
+ * \param data The benchdata_t to use.
+ * \return The amount of read tokens.
+ */
+static size_t
+run_lexer (benchdata_t *data)
+{
+    source_t src;
+    oplog_t log;
+    size_t tokens = 0;
+    int i;
+
+    for (i = 0; i < data->count; i++)
+    {
+        source_init_buffer (&src, data->srcs[i].data, data->srcs[i].len);
+        if (oplog_init (&log, data->files[i]))
+        {
+            lex_create_log (&log, &src, 0);
+            tokens += log.tokens;
+        }
+        oplog_free (&log);
+    }
+    return tokens;
+}
+
+/**
+ * Looks up each node of the graph with get_definition_node().
+ *
+ * \param data The benchdata_t to use.
+ * \return The amount of lookups.
+ */
+static size_t
+run_lookup (benchdata_t *data)
+{
+    g_csr_t *csr = &data->graph.csr;
+    g_id_t i;
+
+    for (i = 0; i < csr->count; i++)
+    {
+        if (!get_definition_node (&data->graph, csr->nodes[i]->name,
+                csr->nodes[i]->file))
+            fprintf (stderr, "%s: Node not found\n", csr->nodes[i]->name);
+    }
+    return (size_t) csr->count;
+}
+
+/**
+ * Looks up names, which are not in the graph, with
+ * get_definition_node().
+ *
+ * \param data The benchdata_t to use.
+ * \return The amount of lookups.
+ */
+static size_t
+run_lookup_miss (benchdata_t *data)
+{
+    g_csr_t *csr = &data->graph.csr;
+    g_id_t i;
+
+    for (i = 0; i < csr->count; i++)
+    {
+        if (get_definition_node (&data->graph, data->misses[i],
+                csr->nodes[i]->file))
+            fprintf (stderr, "%s: Node found\n", data->misses[i]);
+    }
+    return (size_t) csr->count;
+}
+
+/**
+ * Creates a graph with the nodes, but without the calls of the graph of
+ * the inputs.
+ *
+ * \param data The benchdata_t to use.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+setup_edges (benchdata_t *data)
+{
+    g_csr_t *csr = &data->graph.csr;
+    g_node_t *node;
+    g_id_t i;
+
+    init_graph (&data->edges);
+    for (i = 0; i < csr->count; i++)
+    {
+        node = csr->nodes[i];
+        data->targets[i] = add_g_node (&data->edges, node->ntype,
+            node->name, node->type, node->file, node->line);
+        if (!data->targets[i])
+            return FALSE;
+        data->targets[i]->private = node->private;
+    }
+    return TRUE;
+}
+
+/**
+ * Adds the calls of the graph of the inputs with add_to_call_stack().
+ *
+ * \param data The benchdata_t to use.
+ * \return The amount of passed calls.
+ */
+static size_t
+run_edges (benchdata_t *data)
+{
+    g_csr_t *csr = &data->graph.csr;
+    g_subnode_t *calls;
+    g_subnode_t *sub;
+    g_id_t i;
+    g_id_t j;
+    size_t edges = 0;
+
+    for (i = 0; i < csr->count; i++)
+    {
+        calls = NULL;
+        for (j = csr->calloffs[i]; j < csr->calloffs[i + 1]; j++)
+        {
+            sub = create_sub_node (&data->edges,
+                data->targets[csr->callids[j]]);
+            if (!sub)
+                return edges;
+            sub->next = calls;
+            calls = sub;
+            edges++;
+        }
+        if (calls && !add_to_call_stack (&data->edges,
+                data->targets[i]->name, data->targets[i]->file, calls))
+            return edges;
+    }
+    return edges;
+}
+
+/**
+ * Releases the graph of the edges benchmark.
+ *
+ * \param data The benchdata_t to use.
+ */
+static void
+teardown_edges (benchdata_t *data)
+{
+    clear_graph (&data->edges);
+}
+
+/**
+ * Prints the graph of the inputs from its root with print_graph().
+ *
+ * \param data The benchdata_t to use.
+ * \return The amount of printed lines.
+ */
+static size_t
+run_print (benchdata_t *data)
+{
+    print_graph (&data->graph, data->devnull);
+    return data->lines;
+}
+
+/**
+ * Reads the inputs and creates their graph.
+ *
+ * \param data The benchdata_t to fill.
+ * \param files The input files.
+ * \param count The amount of input files.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+prepare (benchdata_t *data, char **files, int count)
+{
+    g_csr_t *csr = &data->graph.csr;
+    FILE *fp;
+    size_t len;
+    g_id_t i;
+    int ch;
+    int f;
+
+    data->files = files;
+    data->count = count;
+    data->srcs = calloc ((size_t) count, sizeof (source_t));
+    if (!data->srcs)
+        goto memerror;
+    for (f = 0; f < count; f++)
+    {
+        if (!source_open (&data->srcs[f], files[f]))
+        {
+            perror (files[f]);
+            return FALSE;
+        }
+    }
+
+    init_graph (&data->graph);
+    if (!create_graph (&data->graph, files, count, 1, lex_file, NULL, NULL)
+        || !freeze_graph (&data->graph))
+        return FALSE;
+
+    data->misses = calloc ((size_t) csr->count + 1, sizeof (char*));
+    data->targets = calloc ((size_t) csr->count + 1, sizeof (g_node_t*));
+    if (!data->misses || !data->targets)
+        goto memerror;
+    for (i = 0; i < csr->count; i++)
+    {
+        len = (size_t) csr->nodes[i]->namelen;
+        data->misses[i] = malloc (len + 2);
+        if (!data->misses[i])
+            goto memerror;
+        memcpy (data->misses[i], csr->nodes[i]->name, len);
+        memcpy (data->misses[i] + len, "$", 2);
+    }
+
+    /* Count the printed lines once. */
+    fp = tmpfile ();
+    if (!fp)
+    {
+        perror ("tmpfile");
+        return FALSE;
+    }
+    print_graph (&data->graph, fileno (fp));
+    rewind (fp);
+    data->lines = 0;
+    while ((ch = getc (fp)) != EOF)
+    {
+        if (ch == '\n')
+            data->lines++;
+    }
+    fclose (fp);
+
+    data->devnull = open ("/dev/null", O_WRONLY);
+    if (data->devnull == -1)
+    {
+        perror ("/dev/null");
+        return FALSE;
+    }
+    return TRUE;
+
+memerror:
+    fprintf (stderr, "Memory allocation error\n");
+    return FALSE;
+}
+
+/**
+ * Runs a benchmark and prints the percentiles of its run times.
+ *
+ * \param bench The bench_t to run.
+ * \param data The benchdata_t to use.
+ * \param warmup The amount of runs, which are not measured.
+ * \param runs The amount of measured runs.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+run_bench (const bench_t *bench, benchdata_t *data, int warmup, int runs)
+{
+    double *times;
+    double start;
+    size_t items = 0;
+    int i;
+
+    times = malloc ((size_t) runs * sizeof (double));
+    if (!times)
+    {
+        fprintf (stderr, "Memory allocation error\n");
+        return FALSE;
+    }
+    for (i = -warmup; i < runs; i++)
+    {
+        if (bench->setup && !bench->setup (data))
+        {
+            free (times);
+            return FALSE;
+        }
+        start = stats_time ();
+        items = bench->run (data);
+        if (i >= 0)
+            times[i] = stats_time () - start;
+        if (bench->teardown)
+            bench->teardown (data);
+    }
+
+    qsort (times, (size_t) runs, sizeof (double), compare_times);
+    printf ("%-12s %10lu %-8s %9.3f %9.3f %9.3f %9.3f %9.3f %13.0f\n",
+        bench->name, (unsigned long) items, bench->unit,
+        times[0] * 1000, percentile (times, runs, 50) * 1000,
+        percentile (times, runs, 90) * 1000,
+        percentile (times, runs, 99) * 1000, times[runs - 1] * 1000,
+        items / percentile (times, runs, 50));
+    free (times);
+    return TRUE;
+}
+
+/**
+ * Entry point for the microbench application. Measures the primitives
+ * of the C lexer, the graph and the printer on the passed files.
+ *
+ * \param argc The argument count.
+ * \param argv The argument array.
+ */
+int
+main (int argc, char *argv[])
+{
+    benchdata_t data;
+    const bench_t *bench;
+    const char *only = NULL; /* Benchmark to run. */
+    int warmup = BENCH_WARMUP;
+    int runs = BENCH_RUNS;
+    int ch;
+    bool_t found = FALSE;
+
+    while ((ch = getopt (argc, argv, "b:n:w:")) != -1)
+    {
+        switch (ch)
+        {
+        case 'b':
+            only = optarg;
+            break;
+        case 'n':
+            runs = atoi (optarg);
+            if (runs < 1)
+                usage ();
+            break;
+        case 'w':
+            warmup = atoi (optarg);
+            if (warmup < 0)
+                usage ();
+            break;
+        default:
+            usage ();
+        }
+    }
+    argc -= optind;
+    argv += optind;
+    if (argc <= 0)
+        usage ();
+
+    memset (&data, 0, sizeof (benchdata_t));
+    if (!prepare (&data, argv, argc))
+        return 1;
+
+    printf ("%-12s %10s %-8s %9s %9s %9s %9s %9s %13s\n", "benchmark",
+        "items/run", "unit", "min ms", "p50 ms", "p90 ms", "p99 ms",
+        "max ms", "items/s p50");
+    for (bench = benches; bench->name; bench++)
+    {
+        if (only && strcmp (only, bench->name) != 0)
+            continue;
+        if (!run_bench (bench, &data, warmup, runs))
+            return 1;
+        found = TRUE;
+    }
+    if (!found)
+    {
+        fprintf (stderr, "%s: Unknown benchmark\n", only);
+        return 1;
+    }
+    return 0;
+}
@@ -42,6 +42,7 @@ __FBSDID("$FreeBSD$");
 
 /* Forward declarations. */
 static void usage (void);
+static bool_t lex_file (oplog_t *log, source_t *src, void *data);
 
 /**
  * Displays the usage command of the application.
@@ -50,10 +51,28 @@ static void
 usage (void)
 {
     fprintf (stderr,
-        "usage: cgraph [-AcCGgPr] [-d num] [-i incl] [-R root] file ...\n");
+        "usage: cgraph [-AcCGgPrs] [-D socket] [-d num] [-i incl] [-j jobs]\n"
+        "              [-k cachedir] [-R root] [-S dbfile] [-t statsfile]\n"
+        "              [-w output] file ...\n"
+        "       cgraph [-AcCGgPrs] [-D socket] [-d num] [-i incl] [-R root]\n"
+        "              [-t statsfile] -L dbfile\n");
     exit (EXIT_FAILURE);
 }
 
+/**
+ * Lexer function for create_graph().
+ *
+ * \param log The oplog_t to record the operations in.
+ * \param src The source to scan.
+ * \param data Pointer to the excluded keyword classes.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+lex_file (oplog_t *log, source_t *src, void *data)
+{
+    return lex_create_log (log, src, *(int *) data);
+}
+
 /**
  * Entry point for the cgraph application. Creates a flow graph for C
  * files according to the POSIX specification.
@@ -64,24 +83,33 @@ usage (void)
 int
 main (int argc, char *argv[])
 {
-    FILE *fp;
     int excludes = 0;      /* Bitwise combineable int to keep track of the
                             * excludes. */
-    node_t *exlist = NULL; /* List of excludes. */
     bool_t statics = FALSE;
     bool_t privates = FALSE;
     char *root = NULL;     /* Root function to use. */
     graph_t graph;         /* Actual graph to process. */
     int ch;                /* Option to parse. */
-    int i;                 /* Counter. */
     int depth = INT_MAX;   /* Depth to traverse. */
+    int jobs = 1;          /* Amount of threads to lex the files. */
+    logcache_t cache = { NULL, 0 }; /* Cache of the lexed files. */
+    char *loaddb = NULL;   /* Graph database to load. */
+    char *sockpath = NULL; /* Socket to serve queries on. */
+    char *savedb = NULL;   /* Graph database to save. */
+    char *watchfile = NULL; /* File to keep the printed graph in. */
+    print_func_t print;     /* Function to print the graph. */
+    char *statsfile = NULL; /* File to write the statistics to. */
+    stats_t stats;          /* Statistics of the run. */
+    double start;           /* Start of printing the graph. */
     bool_t graphviz = FALSE;
     bool_t complete = FALSE;
     bool_t reversed = FALSE;
+    bool_t cycles = FALSE;
 
     setlocale (LC_ALL, "");
+    stats_init (&stats);
 
-    while ((ch = getopt (argc, argv, "AcCd:Ggi:PrR:")) != -1)
+    while ((ch = getopt (argc, argv, "AcCD:d:Ggi:j:k:L:PrR:sS:t:w:")) != -1)
     {
         switch (ch)
         {
@@ -91,6 +119,9 @@ main (int argc, char *argv[])
         case 'c':
             complete = TRUE;
             break;
+        case 'D':
+            sockpath = optarg;
+            break;
         case 'C':
             excludes |= NO_C99_KWDS;
             break;
@@ -120,6 +151,20 @@ main (int argc, char *argv[])
             else
                 usage ();
             break;
+        case 'j':
+        {
+            long val = strtol (optarg, NULL, 10);
+            if (val < 1 || val > INT_MAX)
+                usage ();
+            jobs = (int) val;
+            break;
+        }
+        case 'k':
+            cache.dir = optarg;
+            break;
+        case 'L':
+            loaddb = optarg;
+            break;
         case 'P':
             excludes |= NO_POSIX_KWDS;
             break;
@@ -131,16 +176,18 @@ main (int argc, char *argv[])
             if (!root)
                 exit (EXIT_FAILURE);
             break;
-        }
-    }
-
-    if (excludes)
-    {
-        exlist = create_excludes (exlist, excludes);
-        if (!exlist)
-        {
-            perror (NULL);
-            return 1;
+        case 's':
+            cycles = TRUE;
+            break;
+        case 'S':
+            savedb = optarg;
+            break;
+        case 't':
+            statsfile = optarg;
+            break;
+        case 'w':
+            watchfile = optarg;
+            break;
         }
     }
 
@@ -148,44 +195,86 @@ main (int argc, char *argv[])
     argc -= optind;
     argv += optind;
 
-    if (argc <= 0) /* No more arguments? */
+    if (argc <= 0 && !loaddb) /* No more arguments? */
+        usage ();
+    if (argc > 0 && loaddb) /* Files and a database? */
+        usage ();
+    if (watchfile && loaddb) /* Nothing to watch? */
         usage ();
 
+    init_graph (&graph);
     graph.root = (root) ? root : "main";
-    graph.rootnode = NULL;
-    graph.defines = NULL;
-    graph.defcount = 0;
-    graph.excludes = exlist;
     graph.statics = statics;
     graph.privates = privates;
     graph.depth = depth;
     graph.complete = complete;
     graph.reversed = reversed;
+    if (statsfile)
+        graph.stats = &stats;
 
-    /* Go through all the files and create a graph for each of it. */
-    for (i = 0; i < argc; i++)
+    if (excludes && !create_excludes (&graph, excludes))
     {
-        bool_t retval = FALSE;
-        /* Open the file and create the graph struct to pass around. */
-        fp = fopen (argv[i], "r");
-        if (!fp)
-        {
-            perror (argv[i]);
-            return 1;
-        }
+        perror (NULL);
+        return 1;
+    }
 
-        /* Create the graphs. */
-        retval = lex_create_graph (&graph, fp, argv[i]);
-        fclose (fp);
-        if (!retval)
+    /* Load the graph or go through all the files and create the graph
+     * from them. */
+    cache.key = CACHE_KEY_C | (unsigned int) excludes;
+    if (cache.dir && !cache_check (&cache))
+        cache.dir = NULL;
+    if (loaddb)
+    {
+        if (!load_graph_db (&graph, loaddb))
+            return 1;
+    }
+    else if (!create_graph (&graph, argv, argc, jobs, lex_file, &excludes,
+            (cache.dir) ? &cache : NULL))
+        return 1;
+    if (statsfile && !savedb && (sockpath || watchfile))
+    {
+        /* Serving or watching the graph does not end, so the statistics
+         * of creating it are written beforehand. */
+        graph.stats = NULL;
+        if (!write_stats (&stats, "cgraph", jobs, statsfile))
+            return 1;
+    }
+    if (savedb)
+    {
+        if (!save_graph_db (&graph, savedb))
+            return 1;
+    }
+    else if (sockpath)
+    {
+        if (!serve_graph (&graph, sockpath, (loaddb) ? NULL : lex_file,
+                &excludes, (cache.dir) ? &cache : NULL))
             return 1;
     }
-    if (!graphviz)
-        print_graph (&graph);
     else
-        print_graphviz_graph (&graph);
-    free_nodes (graph.excludes);
-    free_g_nodes (graph.defines);
+    {
+        if (cycles)
+            print = (graphviz) ? print_graphviz_cycles : print_cycles;
+        else
+            print = (graphviz) ? print_graphviz_graph : print_graph;
+        if (watchfile)
+        {
+            if (!watch_graph (&graph, argv, argc, jobs, lex_file, &excludes,
+                    (cache.dir) ? &cache : NULL, print, watchfile))
+                return 1;
+        }
+        else
+        {
+            start = stats_time ();
+            print (&graph, fileno (stdout));
+            stats.printtime = stats_time () - start;
+        }
+    }
+    if (graph.stats && !write_stats (&stats, "cgraph", jobs, statsfile))
+        return 1;
+#if FREE_GRAPH_ON_EXIT
+    clear_graph (&graph);
+    stats_free (&stats);
+#endif
 
     return 0;
 }
@@ -66,6 +66,7 @@ enum
     IDENTIFIER    /* An identifier like 'i' or 'strcmp'. */
 };
 
-bool_t lex_create_graph (graph_t *graph, FILE *fp, char *filename);
+bool_t lex_create_log (oplog_t *log, source_t *src, int excludes);
+bool_t lex_create_graph (graph_t *graph, source_t *src, const char *filename);
 
 #endif /* CGRAPH_H */
@@ -38,296 +38,276 @@ __FBSDID("$FreeBSD$");
 
 #define C_DEBUG 0
 
-/* Marker for the current file offset(s). */
-static int offset = 0;
-static int line = 0;
-
 /* Forward declarations. */
-static int skip_whitespaces (FILE *fp);
-static inline int skip_strings (FILE *fp, int delim);
-static inline int skip_brackets (FILE *fp, int delim);
-static char* get_name (FILE *fp, int ch);
-static int is_reserved (char *name);
-static bool_t is_c_keyword (char *name);
-static bool_t is_excluded (graph_t *graph, char *name);
-static int parse_cpp (FILE *fp, int ch);
-static int get_next_token (graph_t *graph, FILE *fp, char **name);
+static int skip_whitespaces (lexer_t *lex);
+static inline int skip_strings (lexer_t *lex, int delim);
+static bool_t skip_initializer (lexer_t *lex);
+static const char* get_name (source_t *src, size_t *len);
+static int get_reserved_token (int kwds);
+static int parse_cpp (lexer_t *lex, int ch);
+static int get_next_token (lexer_t *lex, const char **name, size_t *namelen);
 
 /**
  * Skips whitespaces, tabs and comments within a file buffer.
  *
- * \param fp The graph to read and skip the whitespaces from.
+ * \param lex The lexer to read and skip the whitespaces for.
  * \return The character value or EOF, if the end of the file was reached.
  */
 static int
-skip_whitespaces (FILE *fp)
+skip_whitespaces (lexer_t *lex)
 {
+    source_t *src = lex->src;
+    const char *p = src->cur;
+    const char *end = src->end;
     int ch;
-    int next;
-
-    if (feof (fp))
-        return EOF;
 
-    do
+    while (p < end)
     {
-        ch = fgetc (fp);
+        ch = (unsigned char) *p++;
 
         if (isspace (ch))
         {
             if (ch == '\n')
-            {
-                line++; /* new line, increase line marker. */
-                offset = 0;
-            }
+                lex->line++; /* new line, increase line marker. */
+            /* Skip the rest of longer runs at once. */
+            if (p < end && isspace ((unsigned char) *p))
+                p = scan_spaces (p, end, &lex->line);
         }
-        else if (ch == '/')
+        else if (ch == '/' && p < end && *p == '/')
         {
-            /* Possible comment block. */
-            next = fgetc (fp);
-            offset++;
-            if (next == '/')
-            {
-                /* Single line comment, skip until a newline. */
-                while (next != '\n' && next != EOF)
-                {
-                    next = fgetc (fp);
-                    offset++;
-                }
-
-                if (next == EOF)
-                    return EOF;
-                    
-                /* Line increment. */
-                offset = 0;
-                line++;
-
-            }
-            else if (next == '*')
+            /* Single line comment, skip until a newline. */
+            p = memchr (p, '\n', (size_t) (end - p));
+            if (!p)
             {
-                /* Multiline comment, skip anything until we reached
-                 * its end. */
-                while (ch != '*' || next != '/')
-                {
-                    ch = next;
-                    next = fgetc (fp);
-                    if (next == EOF)
-                        return EOF;
-                    offset++;
-
-                    if (next == '\n')
-                    {
-                        offset = 0;
-                        line++;
-                    }
-                }
+                src->cur = end;
+                return EOF;
             }
-            else
+            /* Line increment. */
+            p++;
+            lex->line++;
+        }
+        else if (ch == '/' && p < end && *p == '*')
+        {
+            /* Multiline comment, skip anything until we reached its
+             * end. */
+            p = scan_comment (p, end, &lex->line);
+            if (!p)
             {
-                ungetc (next, fp);
-                return ch;
+                src->cur = end;
+                return EOF;
             }
-        } /* if (ch == '/') */
+        }
         else
+        {
+            src->cur = p;
             return ch;
+        }
     }
-    while (!feof (fp));
+    src->cur = p;
     return EOF;
 }
 
 /**
  * Skips characters until the certain delimiter is reached.
  *
- * \param fp The file to read and skip the strings from.
+ * \param lex The lexer to read and skip the strings for.
  * \param delim The delimiter character.
  * \return The next character after the delimiter or EOF.
  */
 static inline int
-skip_strings (FILE *fp, int delim)
+skip_strings (lexer_t *lex, int delim)
 {
-    int ch = '\0';
-     
-    while (ch != EOF && ch != delim)
+    source_t *src = lex->src;
+    const char *p = src->cur;
+    const char *end = src->end;
+    int ch;
+
+    while (TRUE)
     {
-        if (ch == '\\')
-            ch = fgetc (fp);
-        ch = fgetc (fp);
-        if (ch == '\n')
+        /* Find the delimiter or the next escaped character. */
+        p = scan_string (p, end, delim, &lex->line);
+        if (p == end)
         {
-            line++;
-            offset = 0;
+            ch = EOF;
+            break;
         }
-        offset++;
+        ch = (unsigned char) *p++;
+        if (ch == delim)
+            break;
+        if (p < end)
+            p++; /* Skip the escaped character. */
     }
+    src->cur = p;
     return ch;
 }
 
 /**
- * Skips characters until a matching closing bracket for the passed opening
- * bracket is reached.
+ * Skips a brace enclosed initializer at file scope without reading its
+ * tokens, since it cannot contain any calls. The nested braces and
+ * parentheses are matched, while strings and comments are skipped as
+ * usual. The initializer is only skipped, if it is balanced, contains no
+ * preprocessor lines and is followed by a semicolon, so that the state of
+ * the lexer is the same as after reading its tokens. Otherwise the source
+ * is reset to read the tokens instead.
  *
- * \param fp The file to read and skip the characters from.
- * \param delim The opening bracket to use as delimiter. Only '(' and
- *        '[' are recognized.
- * \return The next character after the delimiter or EOF.
+ * \param lex The lexer to skip the initializer for.
+ * \return TRUE, if the initializer was skipped up to the semicolon,
+ *         FALSE otherwise.
  */
-static inline int
-skip_brackets (FILE *fp, int delim)
+static bool_t
+skip_initializer (lexer_t *lex)
 {
-    int ch = '\0';
-    int close = (delim == '(') ? ')' : ']';
-     
-    while (ch != close && ch != EOF)
+    source_t *src = lex->src;
+    const char *start = src->cur;
+    const char *p;
+    int line = lex->line;
+    int braces = 1;
+    int parens = 0;
+    int ch;
+
+    if (skip_whitespaces (lex) != '{')
+        goto reset;
+
+    p = src->cur;
+    while (braces > 0)
     {
-        ch = fgetc (fp);
-        offset++;
+        p = scan_brackets (p, src->end, &lex->line);
+        if (p == src->end)
+            goto reset;
+        ch = (unsigned char) *p++;
+        switch (ch)
+        {
+        case '{':
+            braces++;
+            break;
+        case '}':
+            braces--;
+            break;
+        case '(':
+            parens++;
+            break;
+        case ')':
+            /* The lexer reports the mismatch on its own. */
+            if (--parens < 0)
+                goto reset;
+            break;
+        case '"':
+        case '\'':
+            src->cur = p;
+            if (skip_strings (lex, ch) == EOF)
+                goto reset;
+            p = src->cur;
+            break;
+        case '/':
+            if (p < src->end && (*p == '/' || *p == '*'))
+            {
+                /* Skip the comment and the following whitespaces. */
+                src->cur = p - 1;
+                if (skip_whitespaces (lex) == EOF)
+                    goto reset;
+                p = src->cur - 1;
+            }
+            break;
+        case '#':
+            /* Line markers change the line and file of the lexer. */
+            goto reset;
+        }
     }
-    return ch;
+    if (parens != 0)
+        goto reset;
+
+    src->cur = p;
+    if (skip_whitespaces (lex) != ';')
+        goto reset;
+    source_ungetc (src, ';'); /* Let the lexer read the semicolon. */
+    return TRUE;
+
+reset:
+    src->cur = start;
+    lex->line = line;
+    return FALSE;
 }
 
 /**
- * Reads and returns a name. The return value has to be freed by the
- * caller.
+ * Reads a name. The name is not copied, but returned as a pointer into
+ * the source, which is valid as long as the source is.
  * 
- * \param fp The file to read the name from.
- * \param ch The character to start with.
- * \return A valid C identifier name.
+ * \param src The source to read the name from. Its first character
+ *        must have been read already.
+ * \param len Receives the length of the name.
+ * \return The start of a valid C identifier name within the source.
  */
-static char*
-get_name (FILE *fp, int ch)
+static const char*
+get_name (source_t *src, size_t *len)
 {
-    char *name = NULL;
-    char *tmp = NULL;
-    int i = 0;
-
-    name = malloc (sizeof (char));
-    if (!name)
-        return NULL;
-    name[0] = '\0';
-
-    do
-    {
-        tmp = realloc (name, sizeof (char) * (i + 2));
-        if (!tmp)
-        {
-            if (name)
-                free (name);
-            return NULL;
-        }
-        name = tmp;
-        name[i] = ch;
-        name[i + 1] = '\0';
-        i++;
-
-        ch = fgetc (fp);
-        if (ch == EOF)
-        {
-            free (name);
-            return NULL;
-        }
-        offset++;
-    }
-    while (isalnum (ch) || ch == '_');
-    ungetc (ch, fp); /* Unget the last one. It's not the name. */
-    return name;
+    const char *start = src->cur - 1;
+    const char *p = src->cur;
+
+    while (p < src->end && (isalnum ((unsigned char) *p) || *p == '_'))
+        p++;
+    src->cur = p;
+    *len = (size_t) (p - start);
+    return start;
 }
 
 /**
- * Checks whether the passed name is a reserved name.
+ * Gets the token of a reserved name.
  *
- * \param The NUL-terminated name to check.
- * \return The type of the bane or UNKNOWN in case it could not be
+ * \param kwds The keyword classes of the name as returned by
+ *        keyword_class().
+ * \return The type of the name or UNKNOWN in case it could not be
  *         determined.
  */
 static int
-is_reserved (char *name)
+get_reserved_token (int kwds)
 {
-    if (strcmp ("static", name) == 0)
+    if (kwds & KWD_STATIC)
         return STATIC;
-    else if (strcmp ("typedef", name) == 0)
+    else if (kwds & KWD_TYPEDEF)
         return TYPEDEF;
-    else if (strcmp ("extern", name) == 0)
+    else if (kwds & KWD_EXTERN)
         return EXTERN;
-    else if (strcmp ("struct", name) == 0 || strcmp ("union", name) == 0)
+    else if (kwds & KWD_STRUCT)
         return STRUCT;
-    else if (strcmp ("enum", name) == 0)
+    else if (kwds & KWD_ENUM)
         return ENUM;
     return UNKNOWN;
 }
 
 /**
- * Checks whether the passed name is a C keyword.
- *
- * \param name The NUL-terminated name to check.
- * \return TRUE, if the name is a C keyword, FALSE otherwise.
- */
-static bool_t
-is_c_keyword (char *name)
-{
-    int i;
-    static const char* keywords[] = {
-        "auto", "break", "case", "const", "continue", "default", "do",
-        "else", "for", "goto", "if", "inline", "return", "sizeof", "switch",
-        "volatile", "while", NULL
-    };
-
-    for (i = 0; keywords[i] != NULL; i++)
-        if (strcmp (keywords[i], name) == 0)
-            return TRUE;
-    return FALSE;
-}
-
-/**
- * Checks whether the passed name is excluded by the graph.
- *
- * \param The graph to check for the exvclusion.
- * \param The name to check for the exvclusion.
- * \return TRUE, if the name is excluded, FALSE otherwise.
- */
-static bool_t
-is_excluded (graph_t *graph, char *name)
-{
-    node_t *cur;
-    for (cur = graph->excludes; cur != NULL; cur = cur->next)
-        if (strcmp (cur->name, name) == 0)
-            return TRUE;
-    
-    
-    return FALSE;
-}
-
-/**
- * Parses a C preprocessor directive. The graph's file reader offset
+ * Parses a C preprocessor directive. The source's read position
  * will be advanced to the first character after the directive.
  *
  * Additionally the function will update the line offset and current
  * filename scope for preprocessed files.
  *
- * \param fp The file to parse the directive from.
+ * \param lex The lexer to parse the directive for.
  * \param ch The # of the directive.
- * \return ENDOFFILE on reaching the EOF value of the file reader, or
+ * \return ENDOFFILE on reaching the EOF value of the source, or
  *         UNKNOWN, once the end of the directive is reached.
  */
 static int
-parse_cpp (FILE *fp, int ch)
+parse_cpp (lexer_t *lex, int ch)
 {
+    source_t *src = lex->src;
 
     /* A directive. Treat those specially. */
     if (ch != '#')
         return UNKNOWN;
 
-    ch = skip_whitespaces (fp);
+    ch = skip_whitespaces (lex);
     if (isdigit (ch))
     {
         int i = 0;
         char file[PATH_MAX] = { '\0' };
         
         /* We got some # nn expression - update the line no. */
-        line = ch - '0';
-        ch = fgetc (fp);
+        lex->line = ch - '0';
+        ch = source_getc (src);
         while (isdigit (ch))
         {
-            line = line * 10 + ch - '0';
-            ch = fgetc (fp);
+            lex->line = lex->line * 10 + ch - '0';
+            ch = source_getc (src);
             if (ch == EOF)
                 return ENDOFFILE;
         }
@@ -337,12 +317,13 @@ parse_cpp (FILE *fp, int ch)
          * we need to preserve the filename.
          */
         while (ch != EOF && ch != '"')
-            ch = fgetc (fp);
+            ch = source_getc (src);
         if (ch == EOF)
             return ENDOFFILE;
         
         /* Get the filename. */
-        while ((ch = fgetc (fp)) != '"' && ch != EOF && i < PATH_MAX - 1)
+        while ((ch = source_getc (src)) != '"' && ch != EOF &&
+               i < PATH_MAX - 1)
             file[i++] = ch;
 
         if (ch == EOF)
@@ -353,32 +334,36 @@ parse_cpp (FILE *fp, int ch)
     {
         if (ch == '\\')
         {
-            ch = fgetc (fp);
-            line++;
+            ch = source_getc (src);
+            lex->line++;
         }
-        ch = fgetc (fp);
+        ch = source_getc (src);
     }
     if (ch == '\n')
-        line++;
+        lex->line++;
     return UNKNOWN;
 }
 
 /**
  * Gets the next valid token type from the file.
  *
- * \param graph The graph to get the next token for.
- * \param fp The file to get the next token from.
+ * \param lex The lexer to get the next token for.
+ * \param name Receives the start of an IDENTIFIER within the source or
+ *        NULL, if a keyword or excluded name was read.
+ * \param namelen Receives the length of the IDENTIFIER.
  * \return An enum value indicating the type of token.
  */
 static int
-get_next_token (graph_t *graph, FILE *fp, char **name)
+get_next_token (lexer_t *lex, const char **name, size_t *namelen)
 {
+    source_t *src = lex->src;
     int ch;
-    char *curname = NULL;
+    const char *curname = NULL;
+    size_t len = 0;
 
     do
     {
-        ch = skip_whitespaces (fp);
+        ch = skip_whitespaces (lex);
         switch (ch)
         {
         case EOF:
@@ -391,10 +376,10 @@ get_next_token (graph_t *graph, FILE *fp, char **name)
         case '"':
         case '\'':
             /* Skip string or char literals. */
-            ch = skip_strings (fp, ch);
+            ch = skip_strings (lex, ch);
             if (ch == EOF)
                 return ENDOFFILE;
-            return get_next_token (graph, fp, name);
+            return get_next_token (lex, name, namelen);
 
         case '[':
             return ARRAYSTART;
@@ -406,7 +391,7 @@ get_next_token (graph_t *graph, FILE *fp, char **name)
         case ')':
             return ARGEND;
         case '#':
-            if (parse_cpp (fp, ch) == ENDOFFILE)
+            if (parse_cpp (lex, ch) == ENDOFFILE)
                 return ENDOFFILE;
             break;
         default:
@@ -414,62 +399,49 @@ get_next_token (graph_t *graph, FILE *fp, char **name)
             {
                 /* [A-Z] or _ are allowed values for a name identifier. */
                 int token = UNKNOWN;
+                int kwds;
 
-                if (*name)
-                {
-                    free (*name);
-                    *name = NULL;
-                }
-
-                curname = get_name (fp, ch);
+                *name = NULL;
+                curname = get_name (src, &len);
+                kwds = keyword_class (curname, len);
 
                 /* Check for a builtin keyword. */
-                if (is_c_keyword (curname))
-                {
-                    free (curname);
-                    *name = NULL;
+                if (kwds & KWD_BUILTIN)
                     break;
-                }
 
-                token = is_reserved (curname);
+                token = get_reserved_token (kwds);
                 if (token != UNKNOWN) /* A reserved word was found. */
-                {
-                    free (curname);
-                    *name = NULL;
                     return token;
-                }
 
                 /* Check, if the name is excluded. */
-                if (!is_excluded (graph, curname))
+                if (!(kwds & lex->excludes))
                 {
                     *name = curname;
+                    *namelen = len;
                     return IDENTIFIER;
                 }
-
-                free (curname);
-                *name = NULL;
                 return token;
             }
             else if (ch == '=')
             {
-                ch = fgetc (fp);
+                ch = source_getc (src);
                 if (ch != EOF && ch == '=')
                     return OPERATOR;
                 else
                 {
-                    ungetc (ch, fp);
+                    source_ungetc (src, ch);
                     return ASSIGN;
                 }
             }
             else if (ch == '-')
             {
-                ch = fgetc (fp);
+                ch = source_getc (src);
                 if (ch != EOF && ch == '>')
                     return REFERENCE; /* -> */
                 else
                 {
                     if (ch != '=') /* Sikp -= */
-                        ungetc (ch, fp);
+                        source_ungetc (src, ch);
                     return OPERATOR;
                 }
             }
@@ -477,11 +449,11 @@ get_next_token (graph_t *graph, FILE *fp, char **name)
                      ch == '~' || ch == '>' || ch == '<' || ch == '^' ||
                      ch == '|' || ch == '!')
             {
-                ch = fgetc (fp);
+                ch = source_getc (src);
                 if (ch != EOF && ch == '=')
                     return OPERATOR; /* +=, -= ... */
                 else
-                    ungetc (ch, fp);
+                    source_ungetc (src, ch);
                 return OPERATOR;
             }
             else if (ch == '*')
@@ -501,20 +473,23 @@ get_next_token (graph_t *graph, FILE *fp, char **name)
 }
 
 /**
- * Creates the output graph from the passed graph object.
+ * Records the operations for the graph of a C source in a log.
  *
- * \param graph The graph object to create the output graph for.
- * \param fp The file to create the graph for.
- * \param filename The name of the file.
- * \return TRUE on success, FALSE on error.
+ * \param log The oplog_t to record the operations in.
+ * \param src The source to scan.
+ * \param excludes The excluded keyword classes (NO_*_KWDS).
+ * \return TRUE on success, FALSE on error. In case of an error, the
+ *         error message of the log is set.
  */
 bool_t
-lex_create_graph (graph_t *graph, FILE *fp, char *filename)
+lex_create_log (oplog_t *log, source_t *src, int excludes)
 {
-    char *curtype = NULL;
-    char *curname = NULL; 
-    char *curfunc = NULL;
-    char *name = NULL;       /* The current node name. */
+    lexer_t lex;             /* State of the lexer. */
+    char *curtype = NULL;    /* Current type, interned by the log. */
+    char *curname = NULL;    /* Current name, interned by the log. */
+    char *curfunc = NULL;    /* Current function, interned by the log. */
+    const char *name = NULL; /* The current node name within the source. */
+    size_t namelen = 0;      /* Length of the current node name. */
     int prev = SEMICOLON;    /* Previous token. */
     int token = SEMICOLON;   /* Current token. */
     int modifier = -1;       /* STATIC, EXTERN ... */
@@ -524,13 +499,21 @@ lex_create_graph (graph_t *graph, FILE *fp, char *filename)
     int funcline = -1;
     bool_t maybeknr = FALSE;  /* K&R func declaration */
     bool_t istypedef = FALSE; /* typedef indicator. */
+    bool_t pending = FALSE;   /* Calls or references since the last flush. */
+
+    lex.src = src;
+    lex.log = log;
+    lex.line = 1;
+    lex.field = 0;
+    lex.excludes = excludes;
 
-    g_subnode_t *calls = NULL;
-    line = 1;
-    
     while (prev = token,
-        (token = get_next_token (graph, fp, &name)) != ENDOFFILE)
+        (token = get_next_token (&lex, &name, &namelen)) != ENDOFFILE)
     {
+        log->tokens++;
+        if (token == IDENTIFIER)
+            log->identifiers++;
+
         /* Scope change. */
         if (token == BODYSTART || token == BODYEND)
         {
@@ -538,15 +521,12 @@ lex_create_graph (graph_t *graph, FILE *fp, char *filename)
             if (level < 0)
             {
                 /* That should not happen. */
-                fprintf (stderr, "%s: Brace level mismatch at line %d\n",
-                    filename, line);
-                goto error;
+                oplog_error (log, "Brace level mismatch at line %d",
+                    lex.line);
+                return FALSE;
             }
-            if (!level && curfunc)
-            {
-                free (curfunc);
+            if (!level)
                 curfunc = NULL;
-            }
         }
 
         /* Argument level. */
@@ -556,9 +536,9 @@ lex_create_graph (graph_t *graph, FILE *fp, char *filename)
             if (arglevel < 0)
             {
                 /* That should not happen. */
-                fprintf (stderr, "%s: Brace level mismatch at line %d\n",
-                    filename, line);
-                goto error;
+                oplog_error (log, "Brace level mismatch at line %d",
+                    lex.line);
+                return FALSE;
             }
         }
 
@@ -605,71 +585,50 @@ lex_create_graph (graph_t *graph, FILE *fp, char *filename)
                         if (modifier == STRUCT)
                         {
                             /* STRUCT NAME ... */
-                            char *tmp;
-                            int len = strlen (curtype);
-                            char *foo = strdup (curtype);
-                            if (!foo)
-                                goto memerror;
-                            
-                            tmp = realloc (curtype, sizeof (char) * (len + 8));
-                            if (!tmp)
+                            curtype = strtab_intern_concat (&log->strings,
+                                "struct ", curtype);
+                            if (!curtype)
                                 goto memerror;
-                            curtype = tmp;
-                            strcpy (curtype, "struct ");
-                            strcpy (curtype + 7, foo);
-                            curtype[len + 7] = '\0';
-                            free (foo);
                         }
                         
                         if (strcmp (curtype, "unsigned") == 0)
                         {
                             /* unsigned modifier */
-                            int len = strlen (name);
-                            char *tmp = realloc
-                                (curtype, sizeof (char) * (len + 10));
-                            if (!tmp)
+                            curtype = strtab_intern_len (&log->strings,
+                                name, namelen);
+                            if (!curtype)
+                                goto memerror;
+                            curtype = strtab_intern_concat (&log->strings,
+                                "unsigned ", curtype);
+                            if (!curtype)
                                 goto memerror;
-                            curtype = tmp;
-                            strcpy (curtype, "unsigned ");
-                            strcpy (curtype + 9, name);
-                            curtype[len + 9] = '\0';
                         }
                         else if (prev == POINTER)
                         {
                             /* TYPE* NAME construct */
-                            int len = strlen (curtype);
-                            char *tmp = realloc
-                                (curtype, sizeof (char) * (len + 2));
-                            if (!tmp)
+                            curtype = strtab_intern_concat (&log->strings,
+                                curtype, "*");
+                            if (!curtype)
                                 goto memerror;
-                            curtype = tmp;
-                            curtype[len] = '*';
-                            curtype[len + 1] = '\0';
                         }
                     }
 
                     /* NAME */
-                    if (curname)
+                    if (curname && curtype)
                     {
-                        if (curtype)
-                        {
-                            /* There is already a type - it's possibly a 
-                             * FOO int bar (); construct - move the prev
-                             * name into the type. */
-                            free (curtype);
-                            curtype = strdup (curname);
-                            if (!curtype)
-                                goto memerror;
-                        }
-                        free (curname);
+                        /* There is already a type - it's possibly a 
+                         * FOO int bar (); construct - move the prev
+                         * name into the type. */
+                        curtype = curname;
                     }
-                    curname = strdup (name);
+                    curname = strtab_intern_len (&log->strings, name,
+                        namelen);
                     if (!curname)
                         goto memerror;
 
                     /* Save the current line for the later function
                      * addition. */
-                    funcline = line;
+                    funcline = lex.line;
                 }
                 else if (prev == ARGEND && curtype && curname)
                 {
@@ -679,16 +638,16 @@ lex_create_graph (graph_t *graph, FILE *fp, char *filename)
                 else if (!maybeknr)
                 {
                     /* TYPE */
-                    if (curtype)
-                        free (curtype);
-                    curtype = strdup (name);
+                    curtype = strtab_intern_len (&log->strings, name,
+                        namelen);
                     if (!curtype)
                         goto memerror;
                 }
 #if C_DEBUG
                 if (curtype && curname)
                     printf
-                        ("Found '%s %s' at line %d\n", curtype, curname, line);
+                        ("Found '%s %s' at line %d\n", curtype, curname,
+                         lex.line);
 #endif
             }
         }
@@ -710,9 +669,8 @@ lex_create_graph (graph_t *graph, FILE *fp, char *filename)
                 continue;
             }
             
-            if (curname)
-                free (curname);
-            curname = strdup (name);
+            curname = strtab_intern_len (&log->strings, name,
+                namelen);
             if (!curname)
                 goto memerror;
         }
@@ -724,81 +682,50 @@ lex_create_graph (graph_t *graph, FILE *fp, char *filename)
 
             if (level)
             {
-                /* Function call, create the call node for the temporary
-                 * call stack. */
-                g_subnode_t *sub = NULL;
-                g_node_t *call = get_definition_node (graph->defines, curname,
-                                                      filename);
-                if (!call)
-                {
-                    call = add_g_node (graph, FUNCTION, curname, curtype,
-                                       filename, -1);
-                    if (!call)
-                        goto memerror;
-                    call->private = (modifier == STATIC) ? TRUE : FALSE;
-                    call->ntype = FUNCTION;
-                }
-                sub = create_sub_node (call);
-                if (!sub)
+                /* Function call, add it to the temporary call stack.
+                 * The call node is created on demand. */
+                if (!oplog_add (log, OP_CALL, FUNCTION, curname, curtype, -1,
+                        (modifier == STATIC) ? TRUE : FALSE))
                     goto memerror;
-                if (calls)
-                    sub->next = calls;
-                calls = sub;
+                pending = TRUE;
 #if C_DEBUG
                 printf ("Adding function call '%s' in func '%s', %d\n", curname,
-                        curfunc, line);
+                        curfunc, lex.line);
 #endif
-                free (curname);
                 curname = NULL;
             }
         }
 
         if (prev == ARGEND && token == SEMICOLON && !level)
         {
-            g_node_t *func;
-
             /* TYPE NAME ARGS SEMICOLON - this seems to be a function
              * declaration. */
             if (!curname || !curtype)
                 continue;
-            func = add_g_node (graph, FUNCTION, curname, curtype, filename, -1);
-            if (!func)
+            if (!oplog_add (log, OP_DEFINE, FUNCTION, curname, curtype, -1,
+                    (modifier == STATIC) ? TRUE : FALSE))
                 goto memerror;
 #if C_DEBUG
             printf ("Adding function declaration %s\n", curname);
 #endif
-            func->private = (modifier == STATIC) ? TRUE : FALSE;
-            free (curname);
-            free (curtype);
             curname = NULL;
             curtype = NULL;
-            
+
         }
         else if ((prev == ARGEND && token == BODYSTART) ||
                  (token == BODYSTART && maybeknr))
         {
-            g_node_t *func;
-
             /* TYPE NAME ARGS BODY - this seems to be a function definition. */
             if (!curname || !curtype)
                 continue;
-            func = add_g_node (graph, FUNCTION, curname, curtype, filename,
-                               funcline);
-            if (!func)
+            if (!oplog_add (log, OP_DEFINE, FUNCTION, curname, curtype,
+                    funcline, (modifier == STATIC) ? TRUE : FALSE))
                 goto memerror;
 #if C_DEBUG
             printf ("Adding function definition %s\n", curname);
 #endif
-            func->private = (modifier == STATIC) ? TRUE : FALSE;
-            
-            if (curfunc)
-                free (curfunc);
-            curfunc = strdup (curname);
-            if (!curfunc)
-                goto memerror;
+            curfunc = curname;
 
-            free (curname);
-            free (curtype);
             curname = NULL;
             curtype = NULL;
             funcline = -1;
@@ -808,42 +735,36 @@ lex_create_graph (graph_t *graph, FILE *fp, char *filename)
                  (token == ASSIGN || token == SEMICOLON || token == COMMA ||
                   token == ARRAYSTART) && !maybeknr)
         {
-            g_node_t *var;
-
             /* TYPE NAME [ASSIGN, SEMICOLON, COMMA] - global variable */
             if (!curname || !curtype)
                 continue;
-            var = add_g_node (graph, VARIABLE, curname, curtype, filename,
-                              line); 
-            if (!var)
+            if (!oplog_add (log, OP_DEFINE, VARIABLE, curname, curtype,
+                    lex.line, (modifier == STATIC) ? TRUE : FALSE))
                 goto memerror;
 #if C_DEBUG
             printf ("Adding global variable %s\n", curname);
 #endif
-            var->private = (modifier == STATIC) ? TRUE : FALSE;
-            free (curname);
-            free (curtype);
             curname = NULL;
             curtype = NULL;
         }
+
+        /* ASSIGN { ... } SEMICOLON at file scope - an initializer, which
+         * can be skipped, as if its closing brace was read. */
+        if (token == ASSIGN && !level && !arglevel && !maybeknr &&
+            skip_initializer (&lex))
+            token = BODYEND;
         
         /* { ... NAME ... } - possible variable reference. */ 
         if (token == IDENTIFIER && level && curfunc)
         {
-            g_node_t *node = get_definition_node (graph->defines, name,
-                                                  filename);
-            if (node && node->ntype == VARIABLE)
-            {
-                g_subnode_t *sub = create_sub_node (node);
-                if (!sub)
-                    goto memerror;
-
-                /* Found a global variable reference, add it to the call
-                 * stack. */
-                if (calls)
-                    sub->next = calls;
-                calls = sub;
-            }
+            /* If the name belongs to a global variable, once the log is
+             * replayed, it is added to the call stack. */
+            char *iname = strtab_intern_len (&log->strings, name, namelen);
+            if (!iname)
+                goto memerror;
+            if (!oplog_add (log, OP_REFERENCE, VARIABLE, iname, NULL, -1, -1))
+                goto memerror;
+            pending = TRUE;
         }
             
         if (token == SEMICOLON || (token == ARGEND && lastarglevel > arglevel))
@@ -853,12 +774,13 @@ lex_create_graph (graph_t *graph, FILE *fp, char *filename)
                 /* Reached the end of a statement, reset modifiers and
                    add the calls from the stack to the current
                    function. */
-                if (calls)
+                if (pending)
                 {
-                    if (!add_to_call_stack (graph, curfunc, filename, calls))
-                        goto error;
+                    if (!oplog_add (log, OP_FLUSH, FUNCTION, curfunc, NULL,
+                            -1, -1))
+                        goto memerror;
                 }
-                calls = NULL;
+                pending = FALSE;
             }
         }
 
@@ -867,10 +789,6 @@ lex_create_graph (graph_t *graph, FILE *fp, char *filename)
             if (!maybeknr)
             {
                 modifier = -1;
-                if (curname)
-                    free (curname);
-                if (curtype)
-                    free (curtype);
                 curname = NULL;
                 curtype = NULL;
             }
@@ -879,13 +797,37 @@ lex_create_graph (graph_t *graph, FILE *fp, char *filename)
         }
     }
 
-    if (name)
-        free (name);
     return TRUE;
 
 memerror:
-    fprintf (stderr, "%s: Memory allocation error for line %d\n", filename,
-        line);
-error:
+    oplog_error (log, "Memory allocation error for line %d", lex.line);
     return FALSE;
 }
+
+/**
+ * Creates the output graph from the passed graph object.
+ *
+ * The source can be a file opened with source_open() or a buffer of
+ * the caller passed to source_init_buffer(). The state of the lexer is
+ * kept on the stack, so that different graphs can be created
+ * concurrently.
+ *
+ * \param graph The graph object to create the output graph for.
+ * \param src The source of the file to create the graph for.
+ * \param filename The name of the file.
+ * \return TRUE on success, FALSE on error.
+ */
+bool_t
+lex_create_graph (graph_t *graph, source_t *src, const char *filename)
+{
+    oplog_t log;
+    bool_t retval;
+
+    if (!oplog_init (&log, filename))
+        oplog_error (&log, "Memory allocation error");
+    else
+        lex_create_log (&log, src, graph->excludes);
+    retval = oplog_replay (graph, &log);
+    oplog_free (&log);
+    return retval;
+}
@@ -0,0 +1,163 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+/* Default size of a single arena block. */
+#define ARENA_BLOCK_SIZE (64 * 1024)
+
+/* Alignment of the arena allocations. */
+#define ARENA_ALIGN (sizeof (void *) > sizeof (double) ? \
+    sizeof (void *) : sizeof (double))
+
+/* Header of an arena block. The block data follows the header. */
+typedef struct _arena_block
+{
+    struct _arena_block *next; /* Previously allocated block. */
+    double               align; /* Alignment of the block data. */
+} arena_block_t;
+
+static void* add_block (arena_t *arena, size_t size);
+
+/**
+ * Allocates a new block for the arena, which is large enough to hold
+ * size bytes. Large allocations get their own block, so that the space
+ * left in the current block is not wasted.
+ *
+ * \param arena The arena_t to add the block to.
+ * \param size The amount of bytes to allocate.
+ * \return A pointer to size bytes within the new block or NULL in case
+ *         of an error.
+ */
+static void*
+add_block (arena_t *arena, size_t size)
+{
+    arena_block_t *block;
+    char *data;
+    bool_t large = size > ARENA_BLOCK_SIZE / 4;
+    size_t blocksize = (large) ? size : ARENA_BLOCK_SIZE;
+
+    block = malloc (sizeof (arena_block_t) + blocksize);
+    if (!block)
+        return NULL;
+    data = (char *) (block + 1);
+
+    if (large && arena->blocks)
+    {
+        /* Keep the current block for the following allocations. */
+        block->next = arena->blocks->next;
+        arena->blocks->next = block;
+        return data;
+    }
+
+    block->next = arena->blocks;
+    arena->blocks = block;
+    arena->cur = data + size;
+    arena->end = data + blocksize;
+    return data;
+}
+
+/**
+ * Initializes an empty arena.
+ *
+ * \param arena The arena_t to initialize.
+ */
+void
+arena_init (arena_t *arena)
+{
+    arena->blocks = NULL;
+    arena->cur = NULL;
+    arena->end = NULL;
+}
+
+/**
+ * Allocates memory from the arena. The memory is kept until the arena
+ * is freed using arena_free().
+ *
+ * \param arena The arena_t to allocate the memory from.
+ * \param size The amount of bytes to allocate.
+ * \return A pointer to the allocated memory or NULL in case of an error.
+ */
+void*
+arena_alloc (arena_t *arena, size_t size)
+{
+    void *mem;
+
+    size = (size + ARENA_ALIGN - 1) & ~(ARENA_ALIGN - 1);
+    if (!arena->cur || size > (size_t) (arena->end - arena->cur))
+        return add_block (arena, size);
+
+    mem = arena->cur;
+    arena->cur += size;
+    return mem;
+}
+
+/**
+ * Copies a string into the arena.
+ *
+ * \param arena The arena_t to copy the string into.
+ * \param str The NUL-terminated string to copy.
+ * \return The copy of the string or NULL in case of an error.
+ */
+char*
+arena_strdup (arena_t *arena, const char *str)
+{
+    size_t len = strlen (str) + 1;
+    char *copy = arena_alloc (arena, len);
+    if (!copy)
+        return NULL;
+    memcpy (copy, str, len);
+    return copy;
+}
+
+/**
+ * Frees all memory allocated from the arena.
+ *
+ * \param arena The arena_t to free.
+ */
+void
+arena_free (arena_t *arena)
+{
+    arena_block_t *block = arena->blocks;
+    arena_block_t *next = NULL;
+
+    while (block)
+    {
+        next = block->next;
+        free (block);
+        block = next;
+    }
+    arena_init (arena);
+}
@@ -0,0 +1,469 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+
+#ifdef _MSC_VER
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#ifndef S_ISDIR
+#define S_ISDIR(mode) (((mode) & S_IFMT) == S_IFDIR)
+#endif
+
+#include "graph.h"
+
+/* Magic bytes of a cached log. */
+#define CACHE_MAGIC "CFLOWOPS"
+#define CACHE_MAGIC_LEN 8
+
+/* Format version of the cached logs. Increase it, whenever the lexers or
+ * the operations change, so that older cache files are not used anymore.
+ */
+#define CACHE_VERSION 4
+
+/* Index of a missing string. */
+#define CACHE_NO_STRING 0xffffffffU
+
+/* Header of a cached log. The values are stored in the native byte
+ * order, so that a cache of a different architecture fails the version
+ * check.
+ */
+typedef struct _cacheheader
+{
+    char               magic[CACHE_MAGIC_LEN];
+    unsigned int       version;
+    unsigned int       key;     /* The lexer and its options. */
+    unsigned long long hash;    /* Hash of the source contents. */
+    unsigned long long checksum; /* Hash of the strings and operations. */
+    unsigned long long len;     /* Length of the source contents. */
+    unsigned int       slots;   /* Amount of slots of the string table. */
+    unsigned int       strings; /* Amount of strings. */
+    unsigned long long count;   /* Amount of operations. */
+    unsigned long long tokens;  /* Amount of tokens of the source. */
+    unsigned long long identifiers; /* Amount of identifiers. */
+} cacheheader_t;
+
+/* A cached operation, which refers to the strings by their slot in the
+ * string table of the log. The kind combines the operation, the node
+ * type and the scope.
+ */
+typedef struct _cacheop
+{
+    unsigned int kind;
+    unsigned int line;
+    unsigned int name;
+    unsigned int type;
+} cacheop_t;
+
+/* Buffer to build a cache file in. */
+typedef struct _cachebuf
+{
+    char       *data;
+    size_t      len;
+    size_t      size;
+} cachebuf_t;
+
+static unsigned long long hash_data (const char *data, size_t len);
+static char* get_cache_path (const logcache_t *cache, source_t *src,
+                             unsigned long long hash);
+static bool_t read_data (source_t *file, void *data, size_t len);
+static bool_t read_strings (source_t *file, oplog_t *log, char **strings,
+                            unsigned int slots, unsigned int count);
+static char* get_string (char **strings, unsigned int slots,
+                         unsigned int slot);
+static bool_t write_data (cachebuf_t *buf, const void *data, size_t len);
+
+/**
+ * Calculates a 64-bit hash of the passed data. Like FNV-1a, but the data
+ * is taken eight bytes at a time and the upper half of the hash is
+ * folded into the lower one after each step.
+ *
+ * \param data The data to hash.
+ * \param len The length of the data.
+ * \return The hash value of the data.
+ */
+static unsigned long long
+hash_data (const char *data, size_t len)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    unsigned long long word;
+    const unsigned char *cur = (const unsigned char*) data;
+    const unsigned char *end = cur + len;
+
+    for (; end - cur >= (ptrdiff_t) sizeof (word); cur += sizeof (word))
+    {
+        memcpy (&word, cur, sizeof (word));
+        hash = (hash ^ word) * 1099511628211ULL;
+        hash ^= hash >> 32;
+    }
+    while (cur < end)
+    {
+        hash ^= *cur++;
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+/**
+ * Calculates a 64-bit hash of the contents of a source, see hash_data().
+ *
+ * \param src The source to hash.
+ * \return The hash value of the contents.
+ */
+unsigned long long
+cache_hash (source_t *src)
+{
+    return hash_data (src->data, src->len);
+}
+
+/**
+ * Checks, whether the directory of a cache exists. Otherwise a warning is
+ * printed, since no file could be cached.
+ *
+ * \param cache The logcache_t to check.
+ * \return TRUE, if the directory exists, FALSE otherwise.
+ */
+bool_t
+cache_check (const logcache_t *cache)
+{
+    struct stat st;
+
+    if (stat (cache->dir, &st) == 0 && S_ISDIR (st.st_mode))
+        return TRUE;
+    fprintf (stderr, "%s: Cache directory does not exist, no files will be "
+        "cached\n", cache->dir);
+    return FALSE;
+}
+
+/**
+ * Gets the path of the cache file for a source, which consists of the
+ * hash and length of the contents and the key of the cache.
+ *
+ * \param cache The logcache_t to get the path for.
+ * \param src The source to get the path for.
+ * \param hash The hash value of the source contents.
+ * \return The path, which must be freed by the caller, or NULL in case of
+ *         an error.
+ */
+static char*
+get_cache_path (const logcache_t *cache, source_t *src,
+                unsigned long long hash)
+{
+    size_t len = strlen (cache->dir) + 64;
+    char *path = malloc (len);
+
+    if (!path)
+        return NULL;
+    snprintf (path, len, "%s/%016llx-%llx-%x", cache->dir, hash,
+        (unsigned long long) src->len, cache->key);
+    return path;
+}
+
+/**
+ * Reads data from a cache file.
+ *
+ * \param file The cache file to read from.
+ * \param data The buffer to copy the data to.
+ * \param len The amount of bytes to read.
+ * \return TRUE on success, FALSE, if the file is truncated.
+ */
+static bool_t
+read_data (source_t *file, void *data, size_t len)
+{
+    if ((size_t) (file->end - file->cur) < len)
+        return FALSE;
+    memcpy (data, file->cur, len);
+    file->cur += len;
+    return TRUE;
+}
+
+/**
+ * Reads the strings of a cache file and interns them in the string
+ * table of a log.
+ *
+ * \param file The cache file to read from.
+ * \param log The oplog_t to intern the strings in.
+ * \param strings The strings by their slot in the cached string table.
+ * \param slots The amount of slots of the cached string table.
+ * \param count The amount of strings to read.
+ * \return TRUE on success, FALSE in case of an error or an invalid file.
+ */
+static bool_t
+read_strings (source_t *file, oplog_t *log, char **strings,
+              unsigned int slots, unsigned int count)
+{
+    unsigned int vals[2];
+
+    while (count--)
+    {
+        if (!read_data (file, vals, sizeof (vals)) || vals[0] >= slots ||
+            (size_t) (file->end - file->cur) < vals[1])
+            return FALSE;
+        strings[vals[0]] = strtab_intern_len (&log->strings, file->cur,
+            vals[1]);
+        if (!strings[vals[0]])
+            return FALSE;
+        file->cur += vals[1];
+    }
+    return TRUE;
+}
+
+/**
+ * Gets a string of a cache file by its slot.
+ *
+ * \param strings The strings by their slot in the cached string table.
+ * \param slots The amount of slots of the cached string table.
+ * \param slot The slot of the string.
+ * \return The string or NULL, if the slot is invalid.
+ */
+static char*
+get_string (char **strings, unsigned int slots, unsigned int slot)
+{
+    if (slot >= slots)
+        return NULL;
+    return strings[slot];
+}
+
+/**
+ * Loads the operations for a source from the cache into an empty log.
+ *
+ * \param cache The logcache_t to load the operations from.
+ * \param src The source to load the operations for.
+ * \param hash The hash value of the source contents, see cache_hash().
+ * \param log The empty oplog_t to load the operations into.
+ * \return TRUE, if the operations were loaded, FALSE, if the source is
+ *         not cached or the cache file is invalid or damaged.
+ */
+bool_t
+cache_load (const logcache_t *cache, source_t *src, unsigned long long hash,
+            oplog_t *log)
+{
+    cacheheader_t header;
+    cacheop_t op;
+    unsigned long long i;
+    source_t file;
+    char **strings = NULL;
+    char *path;
+    char *name;
+    char *type;
+    bool_t retval = FALSE;
+
+    path = get_cache_path (cache, src, hash);
+    if (!path)
+        return FALSE;
+    if (!source_open (&file, path))
+    {
+        free (path);
+        return FALSE;
+    }
+    free (path);
+
+    if (!read_data (&file, &header, sizeof (cacheheader_t)) ||
+        memcmp (header.magic, CACHE_MAGIC, CACHE_MAGIC_LEN) != 0 ||
+        header.version != CACHE_VERSION || header.key != cache->key ||
+        header.hash != hash || header.len != src->len ||
+        header.strings > header.slots)
+        goto done;
+
+    /* A damaged cache file would create a wrong graph silently. */
+    if (hash_data (file.cur, (size_t) (file.end - file.cur)) !=
+        header.checksum)
+        goto done;
+
+    strings = calloc ((size_t) header.slots + 1, sizeof (char*));
+    if (!strings ||
+        !read_strings (&file, log, strings, header.slots, header.strings))
+        goto done;
+
+    for (i = 0; i < header.count; i++)
+    {
+        if (!read_data (&file, &op, sizeof (cacheop_t)))
+            goto done;
+        name = get_string (strings, header.slots, op.name);
+        type = get_string (strings, header.slots, op.type);
+        if (!name || (!type && op.type != CACHE_NO_STRING))
+            goto done;
+        if (!oplog_add (log, (OpType) (op.kind & 0xf),
+                (NodeType) ((op.kind >> 4) & 0xf), name, type, (int) op.line,
+                (int) (op.kind >> 8) - 1))
+            goto done;
+    }
+    retval = (file.cur == file.end);
+    log->tokens = (size_t) header.tokens;
+    log->identifiers = (size_t) header.identifiers;
+
+done:
+    free (strings);
+    source_close (&file);
+    if (!retval)
+        log->count = 0;
+    return retval;
+}
+
+/**
+ * Appends data to a cache buffer.
+ *
+ * \param buf The cachebuf_t to append the data to.
+ * \param data The data to append.
+ * \param len The length of the data.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+static bool_t
+write_data (cachebuf_t *buf, const void *data, size_t len)
+{
+    if (buf->len + len > buf->size)
+    {
+        size_t size = (buf->size) ? buf->size : 4096;
+        char *tmp;
+
+        while (size < buf->len + len)
+            size *= 2;
+        tmp = realloc (buf->data, size);
+        if (!tmp)
+            return FALSE;
+        buf->data = tmp;
+        buf->size = size;
+    }
+    memcpy (buf->data + buf->len, data, len);
+    buf->len += len;
+    return TRUE;
+}
+
+/**
+ * Stores the operations of a log for a source in the cache. The cache
+ * file is written under a temporary name first and renamed afterwards,
+ * so that concurrent runs never see partially written files. Errors are
+ * silently ignored, since the source is lexed again on the next run.
+ *
+ * \param cache The logcache_t to store the operations in.
+ * \param src The source the operations belong to.
+ * \param hash The hash value of the source contents, see cache_hash().
+ * \param log The oplog_t to store.
+ */
+void
+cache_store (const logcache_t *cache, source_t *src, unsigned long long hash,
+             oplog_t *log)
+{
+    cacheheader_t header;
+    cacheop_t cop;
+    cachebuf_t buf = { NULL, 0, 0 };
+    strtab_t *tab = &log->strings;
+    op_t *op;
+    op_t *end = log->ops + log->count;
+    unsigned int vals[2];
+    size_t i;
+    char *path;
+    char *tmppath;
+    size_t len;
+    FILE *fp;
+
+    memset (&header, 0, sizeof (cacheheader_t));
+    memcpy (header.magic, CACHE_MAGIC, CACHE_MAGIC_LEN);
+    header.version = CACHE_VERSION;
+    header.key = cache->key;
+    header.hash = hash;
+    header.len = src->len;
+    header.slots = (unsigned int) tab->size;
+    header.strings = (unsigned int) tab->used;
+    header.count = log->count;
+    header.tokens = log->tokens;
+    header.identifiers = log->identifiers;
+    if (!write_data (&buf, &header, sizeof (cacheheader_t)))
+        goto done;
+
+    /* Store each string once by its slot, so that the operations can
+     * refer to it and it needs to be interned only once on loading. */
+    for (i = 0; i < tab->size; i++)
+    {
+        if (!tab->slots[i])
+            continue;
+        vals[0] = (unsigned int) i;
+        vals[1] = (unsigned int) tab->slots[i]->len;
+        if (!write_data (&buf, vals, sizeof (vals)) ||
+            !write_data (&buf, tab->slots[i]->str, vals[1]))
+            goto done;
+    }
+    for (op = log->ops; op != end; op++)
+    {
+        cop.kind = (unsigned int) op->op | ((unsigned int) op->ntype << 4) |
+            ((unsigned int) (op->private + 1) << 8);
+        cop.line = (unsigned int) op->line;
+        cop.name = (unsigned int) strtab_slot (tab, op->name);
+        cop.type = (op->type) ?
+            (unsigned int) strtab_slot (tab, op->type) : CACHE_NO_STRING;
+        if (!write_data (&buf, &cop, sizeof (cacheop_t)))
+            goto done;
+    }
+
+    header.checksum = hash_data (buf.data + sizeof (cacheheader_t),
+        buf.len - sizeof (cacheheader_t));
+    memcpy (buf.data, &header, sizeof (cacheheader_t));
+
+    path = get_cache_path (cache, src, header.hash);
+    if (!path)
+        goto done;
+    len = strlen (path) + 64;
+    tmppath = malloc (len);
+    if (tmppath)
+    {
+        /* The process id and the log keep the name unique for
+         * concurrent runs and jobs. */
+        snprintf (tmppath, len, "%s.%ld.%p.tmp", path, (long) getpid (),
+            (void*) log);
+        fp = fopen (tmppath, "wb");
+        if (fp)
+        {
+            bool_t written = fwrite (buf.data, 1, buf.len, fp) == buf.len;
+            if (fclose (fp) != 0)
+                written = FALSE;
+#ifdef _MSC_VER
+            /* rename() does not replace existing files on Windows. */
+            remove (path);
+#endif
+            if (!written || rename (tmppath, path) != 0)
+                remove (tmppath);
+        }
+        free (tmppath);
+    }
+    free (path);
+
+done:
+    free (buf.data);
+}
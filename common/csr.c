@@ -0,0 +1,239 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <limits.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+/* Marks nodes, which are not part of the previous frozen form. */
+#define NO_CSR_ID ((g_id_t) -1)
+
+static size_t count_subnodes (g_subnode_t *sub);
+static void free_csr (g_csr_t *csr);
+
+/**
+ * Counts the entries of a call or caller list.
+ *
+ * \param sub The list to count.
+ * \return The amount of entries.
+ */
+static size_t
+count_subnodes (g_subnode_t *sub)
+{
+    size_t count = 0;
+    for (; sub; sub = sub->next)
+        count++;
+    return count;
+}
+
+/**
+ * Initializes an empty g_csr_t.
+ *
+ * \param csr The g_csr_t to initialize.
+ */
+void
+init_csr (g_csr_t *csr)
+{
+    csr->nodes = NULL;
+    csr->calloffs = NULL;
+    csr->callids = NULL;
+    csr->calleroffs = NULL;
+    csr->callerids = NULL;
+    csr->sublen = NULL;
+    csr->count = 0;
+    csr->valid = FALSE;
+    csr->mapped = FALSE;
+}
+
+/**
+ * Frees the arrays of a g_csr_t, which do not belong to a loaded graph
+ * database.
+ *
+ * \param csr The g_csr_t to free.
+ */
+static void
+free_csr (g_csr_t *csr)
+{
+    free (csr->nodes);
+    if (!csr->mapped)
+    {
+        free (csr->calloffs);
+        free (csr->callids);
+        free (csr->calleroffs);
+        free (csr->callerids);
+        free (csr->sublen);
+    }
+}
+
+/**
+ * Releases the frozen form of a graph. The graph is frozen again by the
+ * next call to freeze_graph().
+ *
+ * \param graph The graph_t to thaw.
+ */
+void
+thaw_graph (graph_t *graph)
+{
+    free_csr (&graph->csr);
+    init_csr (&graph->csr);
+}
+
+/**
+ * Creates the frozen form of a graph, which keeps the nodes, calls and
+ * callers in a few contiguous arrays. If the graph was not modified
+ * since the last call, the existing frozen form is kept. Otherwise the
+ * nodes are numbered again by their position. Only the calls and
+ * callers of the nodes, which changed, are taken from their lists,
+ * those of the other nodes are copied from the previous frozen form.
+ *
+ * \param graph The graph_t to freeze.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+bool_t
+freeze_graph (graph_t *graph)
+{
+    g_csr_t *csr = &graph->csr;
+    g_csr_t old;
+    g_node_t *cur = NULL;
+    g_subnode_t *sub = NULL;
+    g_id_t *oldids = NULL;
+    g_id_t *map = NULL;
+    size_t calls = 0;
+    size_t callers = 0;
+    size_t count = (size_t) graph->defcount;
+    g_id_t i = 0;
+    g_id_t o;
+    g_id_t k;
+
+    if (csr->valid)
+        return TRUE;
+    if (csr->mapped)
+        thaw_graph (graph);
+    old = *csr;
+    init_csr (csr);
+    if (count >= UINT_MAX)
+        goto memerror;
+
+    csr->nodes = malloc (count * sizeof (g_node_t*) + 1);
+    oldids = malloc (count * sizeof (g_id_t) + 1);
+    map = malloc ((size_t) old.count * sizeof (g_id_t) + 1);
+    if (!csr->nodes || !oldids || !map)
+        goto memerror;
+
+    /* Number the nodes by their position, which changes, when nodes are
+     * added or removed, and map the previous ids to the new ones. */
+    for (cur = graph->defines; cur; cur = cur->next, i++)
+    {
+        csr->nodes[i] = cur;
+        oldids[i] = NO_CSR_ID;
+        if (cur->id >= 0 && cur->id < (long int) old.count &&
+            old.nodes[cur->id] == cur)
+        {
+            o = (g_id_t) cur->id;
+            map[o] = i;
+            if (!cur->changed)
+            {
+                oldids[i] = o;
+                calls += old.calloffs[o + 1] - old.calloffs[o];
+                callers += old.calleroffs[o + 1] - old.calleroffs[o];
+            }
+        }
+        if (oldids[i] == NO_CSR_ID)
+        {
+            calls += count_subnodes (cur->list);
+            callers += count_subnodes (cur->callers);
+        }
+        cur->id = (long int) i;
+    }
+    if (calls >= UINT_MAX || callers >= UINT_MAX)
+        goto memerror;
+
+    csr->calloffs = malloc ((count + 1) * sizeof (g_id_t));
+    csr->callids = malloc (calls * sizeof (g_id_t) + 1);
+    csr->calleroffs = malloc ((count + 1) * sizeof (g_id_t));
+    csr->callerids = malloc (callers * sizeof (g_id_t) + 1);
+    csr->sublen = malloc (count * sizeof (int) + 1);
+    if (!csr->calloffs || !csr->callids || !csr->calleroffs ||
+        !csr->callerids || !csr->sublen)
+        goto memerror;
+
+    calls = 0;
+    callers = 0;
+    for (i = 0; i < count; i++)
+    {
+        cur = csr->nodes[i];
+        csr->calloffs[i] = (g_id_t) calls;
+        csr->calleroffs[i] = (g_id_t) callers;
+        o = oldids[i];
+        if (o != NO_CSR_ID)
+        {
+            /* The calls and callers of an unchanged node still exist,
+             * only their ids need to be mapped. */
+            csr->sublen[i] = old.sublen[o];
+            for (k = old.calloffs[o]; k < old.calloffs[o + 1]; k++)
+                csr->callids[calls++] = map[old.callids[k]];
+            for (k = old.calleroffs[o]; k < old.calleroffs[o + 1]; k++)
+                csr->callerids[callers++] = map[old.callerids[k]];
+            continue;
+        }
+
+        csr->sublen[i] = 0;
+        for (sub = cur->list; sub; sub = sub->next)
+        {
+            /* Keep the longest name of the calls for their
+             * indentation. */
+            if (sub->content->namelen > csr->sublen[i])
+                csr->sublen[i] = sub->content->namelen;
+            csr->callids[calls++] = (g_id_t) sub->content->id;
+        }
+        for (sub = cur->callers; sub; sub = sub->next)
+            csr->callerids[callers++] = (g_id_t) sub->content->id;
+        cur->changed = FALSE;
+    }
+    csr->calloffs[i] = (g_id_t) calls;
+    csr->calleroffs[i] = (g_id_t) callers;
+    csr->count = i;
+    csr->valid = TRUE;
+    free_csr (&old);
+    free (oldids);
+    free (map);
+    return TRUE;
+
+memerror:
+    free_csr (&old);
+    free (oldids);
+    free (map);
+    thaw_graph (graph);
+    fprintf (stderr, "Memory allocation error\n");
+    return FALSE;
+}
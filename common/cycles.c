@@ -0,0 +1,267 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <stdlib.h>
+
+#include "graph.h"
+
+/* Index of a node, which was not found yet. */
+#define UNVISITED ((g_id_t) -1)
+
+/* Node of the depth-first search, whose calls are still visited. */
+typedef struct _visit
+{
+    g_id_t       id;      /* The visited node. */
+    g_id_t       pos;     /* Position of the next call to visit. */
+} visit_t;
+
+/* State of Tarjan's algorithm for strongly connected components. The
+ * arrays are indexed by the id of the nodes.
+ */
+typedef struct _tarjan
+{
+    g_csr_t     *csr;     /* The frozen graph. */
+    g_id_t      *index;   /* Order, in which the nodes were found. */
+    g_id_t      *lowlink; /* Lowest index reachable from a node. */
+    bool_t      *onstack; /* Indicates, whether a node is on the stack. */
+    g_id_t      *stack;   /* Nodes of the components found so far. */
+    g_id_t       stacklen; /* Amount of nodes on the stack. */
+    visit_t     *visits;  /* Explicit stack of the depth-first search. */
+    g_id_t       visitlen; /* Amount of visited nodes on the stack. */
+    g_id_t       counter; /* Next index to assign. */
+    long int     groups;  /* Amount of recursion groups found. */
+} tarjan_t;
+
+static bool_t calls_itself (g_csr_t *csr, g_id_t id);
+static void enter_node (tarjan_t *state, g_id_t id);
+static void close_component (tarjan_t *state, g_id_t id);
+static void search_components (tarjan_t *state, g_id_t root);
+
+/**
+ * Checks, whether a function calls itself directly.
+ *
+ * \param csr The frozen graph.
+ * \param id The id of the node to check.
+ * \return TRUE, if the node calls itself, FALSE otherwise.
+ */
+static bool_t
+calls_itself (g_csr_t *csr, g_id_t id)
+{
+    g_id_t i;
+
+    for (i = csr->calloffs[id]; i < csr->calloffs[id + 1]; i++)
+    {
+        if (csr->callids[i] == id)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/**
+ * Assigns the next index to a node and starts visiting its calls.
+ *
+ * \param state The tarjan_t state of the search.
+ * \param id The id of the node to visit.
+ */
+static void
+enter_node (tarjan_t *state, g_id_t id)
+{
+    visit_t *visit = &state->visits[state->visitlen++];
+
+    state->index[id] = state->counter;
+    state->lowlink[id] = state->counter;
+    state->counter++;
+    state->stack[state->stacklen++] = id;
+    state->onstack[id] = TRUE;
+    visit->id = id;
+    visit->pos = state->csr->calloffs[id];
+}
+
+/**
+ * Removes the component of a node from the stack, once all of its
+ * calls were visited. Components, which consist of several nodes or of
+ * a function, that calls itself, are marked as recursion group.
+ *
+ * \param state The tarjan_t state of the search.
+ * \param id The id of the root node of the component.
+ */
+static void
+close_component (tarjan_t *state, g_id_t id)
+{
+    g_id_t member;
+    bool_t recursive;
+
+    recursive = state->stack[state->stacklen - 1] != id ||
+        calls_itself (state->csr, id);
+    do
+    {
+        member = state->stack[--state->stacklen];
+        state->onstack[member] = FALSE;
+        if (recursive)
+            state->csr->nodes[member]->scc = state->groups;
+    }
+    while (member != id);
+
+    if (recursive)
+        state->groups++;
+}
+
+/**
+ * Searches the strongly connected components, which can be reached from
+ * a node, using an explicit stack instead of recursion.
+ *
+ * \param state The tarjan_t state of the search.
+ * \param root The id of the node to start from.
+ */
+static void
+search_components (tarjan_t *state, g_id_t root)
+{
+    g_csr_t *csr = state->csr;
+    visit_t *visit = NULL;
+    g_id_t id;
+    g_id_t callee;
+
+    enter_node (state, root);
+    while (state->visitlen > 0)
+    {
+        visit = &state->visits[state->visitlen - 1];
+        id = visit->id;
+        if (visit->pos < csr->calloffs[id + 1])
+        {
+            callee = csr->callids[visit->pos++];
+            if (state->index[callee] == UNVISITED)
+                enter_node (state, callee);
+            else if (state->onstack[callee] &&
+                state->index[callee] < state->lowlink[id])
+                state->lowlink[id] = state->index[callee];
+            continue;
+        }
+
+        /* All calls are visited, pass the lowlink to the caller. */
+        state->visitlen--;
+        if (state->visitlen > 0)
+        {
+            g_id_t caller = state->visits[state->visitlen - 1].id;
+            if (state->lowlink[id] < state->lowlink[caller])
+                state->lowlink[caller] = state->lowlink[id];
+        }
+        if (state->lowlink[id] == state->index[id])
+            close_component (state, id);
+    }
+}
+
+/**
+ * Finds the recursion groups of a graph. A recursion group is a
+ * strongly connected component of the call graph, which consists of
+ * several functions calling each other or of a single function calling
+ * itself. The scc member of the nodes is set to the number of their
+ * group, starting at 0 in the order of the definitions, or to -1, if
+ * a node is not recursive. This runs in linear time on the frozen
+ * graph.
+ *
+ * \param graph The graph_t to find the recursion groups for.
+ * \return The amount of recursion groups or -1 in case of an error.
+ */
+long int
+find_cycles (graph_t *graph)
+{
+    tarjan_t state;
+    g_csr_t *csr = &graph->csr;
+    long int *numbers = NULL;
+    long int next = 0;
+    size_t count;
+    g_id_t i;
+
+    if (!freeze_graph (graph))
+        return -1;
+
+    count = (size_t) csr->count;
+    state.csr = csr;
+    state.index = malloc (count * sizeof (g_id_t) + 1);
+    state.lowlink = malloc (count * sizeof (g_id_t) + 1);
+    state.onstack = calloc (count + 1, sizeof (bool_t));
+    state.stack = malloc (count * sizeof (g_id_t) + 1);
+    state.visits = malloc (count * sizeof (visit_t) + 1);
+    state.stacklen = 0;
+    state.visitlen = 0;
+    state.counter = 0;
+    state.groups = 0;
+    if (!state.index || !state.lowlink || !state.onstack || !state.stack ||
+        !state.visits)
+        goto memerror;
+
+    for (i = 0; i < csr->count; i++)
+    {
+        state.index[i] = UNVISITED;
+        csr->nodes[i]->scc = -1;
+    }
+    for (i = 0; i < csr->count; i++)
+    {
+        if (state.index[i] == UNVISITED)
+            search_components (&state, i);
+    }
+
+    /* Number the groups in the order of their first definition, so
+     * that the numbers do not depend on the order of the search. */
+    numbers = malloc ((size_t) state.groups * sizeof (long int) + 1);
+    if (!numbers)
+        goto memerror;
+    for (next = 0; next < state.groups; next++)
+        numbers[next] = -1;
+    next = 0;
+    for (i = 0; i < csr->count; i++)
+    {
+        g_node_t *cur = csr->nodes[i];
+        if (cur->scc == -1)
+            continue;
+        if (numbers[cur->scc] == -1)
+            numbers[cur->scc] = next++;
+        cur->scc = numbers[cur->scc];
+    }
+
+    free (numbers);
+    free (state.index);
+    free (state.lowlink);
+    free (state.onstack);
+    free (state.stack);
+    free (state.visits);
+    return state.groups;
+
+memerror:
+    free (state.index);
+    free (state.lowlink);
+    free (state.onstack);
+    free (state.stack);
+    free (state.visits);
+    fprintf (stderr, "Memory allocation error\n");
+    return -1;
+}
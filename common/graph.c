@@ -29,56 +29,213 @@
 __FBSDID("$FreeBSD$");
 #endif
 
+#include <limits.h>
 #include <string.h>
 #include <stdlib.h>
 
 #include "graph.h"
-#include "ansi_keywords.h"
-#include "posix_keywords.h"
-#include "c99_keywords.h"
-#include "gcc_keywords.h"
 
-static void free_g_node (g_node_t *node);
-static inline node_t* add_excludes (node_t *excludes, const char* keywords[]);
+/* Initial amount of slots for the definition index and edge sets. */
+#define INDEX_INITIAL_SIZE 256
+
+/* Id of a node, which was removed from the graph and is kept for
+ * reuse. */
+#define REMOVED_NODE -2
+
+static bool_t grow_index (g_index_t *index);
+static g_node_t** lookup_index (g_index_t *index, const char *name);
+static bool_t add_to_index (graph_t *graph, g_node_t *node);
+static void remove_from_index (graph_t *graph, g_node_t *node);
+static inline unsigned int hash_node (g_node_t *node);
+static inline unsigned int hash_edge (g_edgeset_t *set, g_node_t *from,
+                                      g_node_t *to);
+static bool_t grow_edgeset (g_edgeset_t *set);
+static int add_edge (g_edgeset_t *set, g_node_t *from, g_node_t *to);
+static g_edge_t* find_edge (g_edgeset_t *set, g_node_t *from,
+                            g_node_t *to);
+static void delete_edge (g_edgeset_t *set, g_edge_t *edge);
+static void remove_edge (g_edgeset_t *set, g_node_t *from, g_node_t *to);
+static void init_edgeset (g_edgeset_t *set, bool_t byname);
+static g_node_t* find_definition_node (graph_t *graph, char *name,
+                                       char *filename);
+static bool_t push_node (g_nodes_t *nodes, g_node_t *node);
+static int compare_nodes (const void *a, const void *b);
+static void unique_nodes (g_nodes_t *nodes);
+static g_file_t** lookup_file (g_files_t *files, const char *name);
+static bool_t grow_files (g_files_t *files);
+static void release_sub_node (graph_t *graph, g_subnode_t *sub);
+static void remove_node (graph_t *graph, g_node_t *node);
+static void remove_unused_node (graph_t *graph, g_node_t *node);
+static void unlink_caller (graph_t *graph, g_node_t *node,
+                           g_node_t *caller);
+static void drop_call (graph_t *graph, g_node_t *parent, g_subnode_t *sub);
+static void retract_calls (graph_t *graph, g_node_t *parent,
+                           const char *file);
 
 /**
- * Frees the passed g_node_t.
+ * Doubles the amount of slots of the passed index and rehashes the
+ * existing entries.
  *
- * \param node The g_node_t to free.
+ * \param index The g_index_t to grow.
+ * \return TRUE on success, FALSE in case of an error.
  */
-static void
-free_g_node (g_node_t *node)
+static bool_t
+grow_index (g_index_t *index)
 {
-    g_subnode_t *tmp = node->list;
-    g_subnode_t *prev = NULL;
+    size_t i;
+    size_t size = (index->size) ? index->size * 2 : INDEX_INITIAL_SIZE;
+    g_node_t **old = index->slots;
+    g_node_t **slots = calloc (size, sizeof (g_node_t *));
+    if (!slots)
+        return FALSE;
 
-    free (node->name);
-    if (node->type)
-        free (node->type);
-    if (node->file)
-        free (node->file);
-    while (tmp)
+    for (i = 0; i < index->size; i++)
     {
-        prev = tmp;
-        tmp = tmp->next;
-        free (prev);
+        size_t pos;
+        if (!old[i])
+            continue;
+        pos = ISTR (old[i]->name)->hash & (size - 1);
+        while (slots[pos])
+            pos = (pos + 1) & (size - 1);
+        slots[pos] = old[i];
     }
 
-    tmp = node->callers;
-    while (tmp)
+    free (old);
+    index->slots = slots;
+    index->size = size;
+    return TRUE;
+}
+
+/**
+ * Gets the slot of the index, that holds the first definition with the
+ * passed name. If no definition with that name exists, the empty slot,
+ * in which it would be placed, is returned.
+ *
+ * \param index The g_index_t to search.
+ * \param name The interned name to search for.
+ * \return The slot for the name or NULL, if the index is empty.
+ */
+static g_node_t**
+lookup_index (g_index_t *index, const char *name)
+{
+    size_t pos;
+
+    if (!index->size)
+        return NULL;
+
+    pos = ISTR (name)->hash & (index->size - 1);
+    while (index->slots[pos])
     {
-        prev = tmp;
-        tmp = tmp->next;
-        free (prev);
+        if (index->slots[pos]->name == name)
+            break;
+        pos = (pos + 1) & (index->size - 1);
+    }
+    return &index->slots[pos];
+}
+
+/**
+ * Adds a definition node to the name index of the graph.
+ *
+ * \param graph The graph to add the node to.
+ * \param node The g_node_t to add.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+static bool_t
+add_to_index (graph_t *graph, g_node_t *node)
+{
+    g_index_t *index = &graph->index;
+    g_node_t **slot = NULL;
+    g_node_t *cur = NULL;
+
+    /* Keep the load factor below 1/2 to keep the probe chains short. */
+    if ((index->used + 1) * 2 > index->size)
+    {
+        if (!grow_index (index))
+            return FALSE;
     }
 
-    free (node);
+    slot = lookup_index (index, node->name);
+    if (!*slot)
+    {
+        *slot = node;
+        index->used++;
+        return TRUE;
+    }
+
+    /* Append it to the nodes with the same name. */
+    cur = *slot;
+    while (cur->samename)
+        cur = cur->samename;
+    cur->samename = node;
+    return TRUE;
 }
 
 /**
- * Creates a new g_node_t node. The return value has to be freed by the
- * caller.
+ * Removes a definition node from the name index of the graph. Slots,
+ * which become empty, are filled again by moving the following entries
+ * of the probe chain backwards.
  *
+ * \param graph The graph to remove the node from.
+ * \param node The g_node_t to remove.
+ */
+static void
+remove_from_index (graph_t *graph, g_node_t *node)
+{
+    g_index_t *index = &graph->index;
+    g_node_t **slot = lookup_index (index, node->name);
+    g_node_t *cur = NULL;
+    size_t mask;
+    size_t hole;
+    size_t pos;
+    size_t home;
+
+    if (!slot || !*slot)
+        return;
+    if (*slot != node)
+    {
+        for (cur = *slot; cur->samename; cur = cur->samename)
+        {
+            if (cur->samename == node)
+            {
+                cur->samename = node->samename;
+                break;
+            }
+        }
+        return;
+    }
+    if (node->samename)
+    {
+        *slot = node->samename;
+        return;
+    }
+
+    mask = index->size - 1;
+    hole = (size_t) (slot - index->slots);
+    pos = hole;
+    while (TRUE)
+    {
+        pos = (pos + 1) & mask;
+        if (!index->slots[pos])
+            break;
+        /* Move the entry into the hole, unless its home slot lies
+         * between the hole and the entry. */
+        home = ISTR (index->slots[pos]->name)->hash & mask;
+        if (((pos - home) & mask) >= ((pos - hole) & mask))
+        {
+            index->slots[hole] = index->slots[pos];
+            hole = pos;
+        }
+    }
+    index->slots[hole] = NULL;
+    index->used--;
+}
+
+/**
+ * Creates a new g_node_t node. The node is allocated from the arena of
+ * the graph or reuses a removed node, its names are interned in the
+ * string table of the graph.
+ *
+ * \param graph The graph to create the node for.
  * \param name The name of the node.
  * \param type The type of the node.
  * \param file The file the node belongs to.
@@ -86,158 +243,490 @@ free_g_node (g_node_t *node)
  * \return A new g_node_t or NULL in case of an error.
  */
 g_node_t*
-create_g_node (char *name, char *type, char *file, int line)
+create_g_node (graph_t *graph, char *name, char *type, char *file, int line)
 {
-    g_node_t *new = malloc (sizeof (g_node_t));
-    if (!new)
-        return NULL;
+    g_node_t *new = graph->freenodes;
 
-    new->name = strdup (name);
-    if (!new->name)
+    if (new)
+        graph->freenodes = new->next;
+    else
     {
-        free (new);
-        return NULL;
+        new = arena_alloc (&graph->arena, sizeof (g_node_t));
+        if (!new)
+            return NULL;
     }
-    new->namelen = strlen (name);
+
+    new->name = strtab_intern (&graph->strings, name);
+    if (!new->name)
+        return NULL;
+    new->namelen = ISTR (new->name)->len;
 
     new->type = NULL;
     if (type)
     { 
-        new->type = strdup (type);
+        new->type = strtab_intern (&graph->strings, type);
         if (!new->type)
-        {
-            free (new->name);
-            free (new);
             return NULL;
-        }
     }
 
+    new->file = NULL;
     if (file)
     { 
-        new->file = strdup (file);
+        new->file = strtab_intern (&graph->strings, file);
         if (!new->file)
-        {
-            free (new->name);
-            if (new->type)
-                free (new->type);
-            free (new);
             return NULL;
-        }
     }
 
+    new->id = -1;
     new->line = line;
     new->next = NULL;
+    new->prev = NULL;
+    new->samename = NULL;
     new->list = NULL;
+    new->listtail = NULL;
     new->callers = NULL;
+    new->callerstail = NULL;
     new->private = FALSE;
     new->printed = FALSE;
+    new->changed = TRUE;
+    new->scc = -1;
     return new;
 }
 
 /**
- * Creates a subnode entry for a certain g_node_t. The return value has
- * to be freed by the caller.
+ * Creates a subnode entry for a certain g_node_t. Subnodes, which were
+ * released earlier, are reused.
  *
+ * \param graph The graph to create the subnode for.
  * \param node The g_node_t to create the subnode for.
  * \return A new g_subnode_t or NULL in case of an error.
  */
 g_subnode_t*
-create_sub_node (g_node_t *node)
+create_sub_node (graph_t *graph, g_node_t *node)
 {
-    g_subnode_t *sub = malloc (sizeof (g_subnode_t));
-    if (!sub)
-        return NULL;
+    g_subnode_t *sub = graph->freesubs;
+
+    if (sub)
+        graph->freesubs = sub->next;
+    else
+    {
+        sub = arena_alloc (&graph->arena, sizeof (g_subnode_t));
+        if (!sub)
+            return NULL;
+    }
     sub->next = NULL;
     sub->content = node;
+    sub->owner = NULL;
     return sub;
 }
 
 /**
- * Gets the g_node_t from the list, that has the passed name.
+ * Calculates the hash value for a node, which does not change, while
+ * the node is part of the graph.
  *
- * \param list The list to get the node from.
- * \param name The NUL-terminated name to check for.
- * \param filename The definition filename.
- * \return A g_node_t with the name or NULL if none was found.
+ * \param node The g_node_t to calculate the hash value for.
+ * \return The hash value of the node.
  */
-g_node_t*
-get_definition_node (g_node_t *list, char *name, char *filename)
+static inline unsigned int
+hash_node (g_node_t *node)
 {
-    g_node_t *cur = list;
-    while (cur)
+    return (unsigned int) ((size_t) node / sizeof (void*)) * 2654435761U;
+}
+
+/**
+ * Calculates the hash value for an edge of the passed edge set.
+ *
+ * \param set The g_edgeset_t the edge belongs to.
+ * \param from The node the edge starts at.
+ * \param to The node the edge points to.
+ * \return The hash value of the edge.
+ */
+static inline unsigned int
+hash_edge (g_edgeset_t *set, g_node_t *from, g_node_t *to)
+{
+    unsigned int hash = (set->byname) ? ISTR (to->name)->hash :
+        hash_node (to);
+    return hash ^ (hash_node (from) + 0x9E3779B9U + (hash << 6) +
+        (hash >> 2));
+}
+
+/**
+ * Doubles the amount of slots of the passed edge set and rehashes the
+ * existing entries.
+ *
+ * \param set The g_edgeset_t to grow.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+static bool_t
+grow_edgeset (g_edgeset_t *set)
+{
+    size_t i;
+    size_t size = (set->size) ? set->size * 2 : INDEX_INITIAL_SIZE;
+    g_edge_t *old = set->slots;
+    g_edge_t *slots = calloc (size, sizeof (g_edge_t));
+    if (!slots)
+        return FALSE;
+
+    for (i = 0; i < set->size; i++)
+    {
+        size_t pos;
+        if (!old[i].from)
+            continue;
+        pos = hash_edge (set, old[i].from, old[i].to) & (size - 1);
+        while (slots[pos].from)
+            pos = (pos + 1) & (size - 1);
+        slots[pos] = old[i];
+    }
+
+    free (old);
+    set->slots = slots;
+    set->size = size;
+    return TRUE;
+}
+
+/**
+ * Adds an edge to the passed edge set, if it does not exist already.
+ * If the set compares by name, an edge to another node with the same
+ * name as the passed target node is considered to be the same edge.
+ *
+ * \param set The g_edgeset_t to add the edge to.
+ * \param from The node the edge starts at.
+ * \param to The node the edge points to.
+ * \return 1, if the edge was added, 0, if it existed already, -1 in
+ *         case of an error.
+ */
+static int
+add_edge (g_edgeset_t *set, g_node_t *from, g_node_t *to)
+{
+    size_t pos;
+    g_edge_t *edge;
+
+    /* Keep the load factor below 1/2 to keep the probe chains short. */
+    if ((set->used + 1) * 2 > set->size)
+    {
+        if (!grow_edgeset (set))
+            return -1;
+    }
+
+    pos = hash_edge (set, from, to) & (set->size - 1);
+    while ((edge = &set->slots[pos])->from)
+    {
+        if (edge->from == from && (edge->to == to ||
+            (set->byname && edge->to->name == to->name)))
+            return 0;
+        pos = (pos + 1) & (set->size - 1);
+    }
+    edge->from = from;
+    edge->to = to;
+    set->used++;
+    return 1;
+}
+
+/**
+ * Gets the edge between exactly the passed nodes from an edge set.
+ *
+ * \param set The g_edgeset_t to search.
+ * \param from The node the edge starts at.
+ * \param to The node the edge points to.
+ * \return The g_edge_t or NULL, if the edge does not exist.
+ */
+static g_edge_t*
+find_edge (g_edgeset_t *set, g_node_t *from, g_node_t *to)
+{
+    size_t pos;
+    g_edge_t *edge;
+
+    if (!set->size)
+        return NULL;
+
+    pos = hash_edge (set, from, to) & (set->size - 1);
+    while ((edge = &set->slots[pos])->from)
+    {
+        if (edge->from == from && edge->to == to)
+            return edge;
+        pos = (pos + 1) & (set->size - 1);
+    }
+    return NULL;
+}
+
+/**
+ * Deletes an edge from its edge set. Like for the name index, the
+ * following entries of the probe chain are moved into the free slot.
+ *
+ * \param set The g_edgeset_t to delete the edge from.
+ * \param edge The g_edge_t to delete.
+ */
+static void
+delete_edge (g_edgeset_t *set, g_edge_t *edge)
+{
+    size_t mask = set->size - 1;
+    size_t hole = (size_t) (edge - set->slots);
+    size_t pos = hole;
+    size_t home;
+
+    while (TRUE)
     {
-        if (strcmp (cur->name, name) == 0)
+        pos = (pos + 1) & mask;
+        if (!set->slots[pos].from)
+            break;
+        home = hash_edge (set, set->slots[pos].from, set->slots[pos].to) &
+            mask;
+        if (((pos - home) & mask) >= ((pos - hole) & mask))
         {
-            if (cur->private)
-            {
-                if (strcmp (cur->file, filename) == 0)
-                    return cur;
-                else
-                    cur = cur->next;
-            }
-            else
-                return cur;
+            set->slots[hole] = set->slots[pos];
+            hole = pos;
         }
-        cur = cur->next;
     }
-    return NULL;
+    set->slots[hole].from = NULL;
+    set->slots[hole].to = NULL;
+    set->used--;
 }
 
 /**
- * Adds a new node to a given node_t list.
+ * Removes an edge from an edge set.
  *
- * \param list The list to add the node to or NULL for a new list.
- * \param name The name of the new node.
- * \return The (new) list.
+ * \param set The g_edgeset_t to remove the edge from.
+ * \param from The node the edge starts at.
+ * \param to The node the edge points to.
  */
-node_t*
-add_node (node_t *list, const char *name)
+static void
+remove_edge (g_edgeset_t *set, g_node_t *from, g_node_t *to)
 {
-    node_t *add = NULL;
-    node_t *tmp = NULL;
-     
-    add = malloc (sizeof (node_t));
-    if (!add)
+    g_edge_t *edge = find_edge (set, from, to);
+    if (edge)
+        delete_edge (set, edge);
+}
+
+/**
+ * Initializes an empty edge set.
+ *
+ * \param set The g_edgeset_t to initialize.
+ * \param byname Indicates, whether the target nodes shall be compared
+ *        by their name.
+ */
+static void
+init_edgeset (g_edgeset_t *set, bool_t byname)
+{
+    set->slots = NULL;
+    set->size = 0;
+    set->used = 0;
+    set->byname = byname;
+}
+
+/**
+ * Appends a node to a growable array of nodes.
+ *
+ * \param nodes The g_nodes_t to append the node to.
+ * \param node The g_node_t to append.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+static bool_t
+push_node (g_nodes_t *nodes, g_node_t *node)
+{
+    g_node_t **tmp = NULL;
+    size_t size;
+
+    if (nodes->count == nodes->size)
+    {
+        size = (nodes->size) ? nodes->size * 2 : 16;
+        tmp = realloc (nodes->nodes, size * sizeof (g_node_t *));
+        if (!tmp)
+            return FALSE;
+        nodes->nodes = tmp;
+        nodes->size = size;
+    }
+    nodes->nodes[nodes->count++] = node;
+    return TRUE;
+}
+
+/**
+ * Compares two node pointers for unique_nodes().
+ *
+ * \param a The first g_node_t pointer.
+ * \param b The second g_node_t pointer.
+ * \return A negative value, zero or a positive value, if the first node
+ *         is located before, at or behind the second one.
+ */
+static int
+compare_nodes (const void *a, const void *b)
+{
+    const g_node_t *na = *(g_node_t * const *) a;
+    const g_node_t *nb = *(g_node_t * const *) b;
+    return (na < nb) ? -1 : (na > nb);
+}
+
+/**
+ * Sorts an array of nodes and removes the duplicate entries.
+ *
+ * \param nodes The g_nodes_t to make unique.
+ */
+static void
+unique_nodes (g_nodes_t *nodes)
+{
+    size_t i;
+    size_t count = 0;
+
+    if (nodes->count < 2)
+        return;
+    qsort (nodes->nodes, nodes->count, sizeof (g_node_t *), compare_nodes);
+    for (i = 0; i < nodes->count; i++)
+    {
+        if (count == 0 || nodes->nodes[count - 1] != nodes->nodes[i])
+            nodes->nodes[count++] = nodes->nodes[i];
+    }
+    nodes->count = count;
+}
+
+/**
+ * Gets the slot of the file table, that holds the record of the passed
+ * file. If no record exists, the empty slot, in which it would be
+ * placed, is returned.
+ *
+ * \param files The g_files_t to search.
+ * \param name The interned name of the file.
+ * \return The slot for the file or NULL, if the table is empty.
+ */
+static g_file_t**
+lookup_file (g_files_t *files, const char *name)
+{
+    size_t pos;
+
+    if (!files->size)
         return NULL;
 
-    /* Copy name. */
-    add->name = strdup (name);
-    if (!add->name)
+    pos = ISTR (name)->hash & (files->size - 1);
+    while (files->slots[pos])
     {
-        free (add);
+        if (files->slots[pos]->name == name)
+            break;
+        pos = (pos + 1) & (files->size - 1);
+    }
+    return &files->slots[pos];
+}
+
+/**
+ * Doubles the amount of slots of the passed file table and rehashes the
+ * existing records.
+ *
+ * \param files The g_files_t to grow.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+static bool_t
+grow_files (g_files_t *files)
+{
+    size_t i;
+    size_t size = (files->size) ? files->size * 2 : INDEX_INITIAL_SIZE;
+    g_file_t **old = files->slots;
+    g_file_t **slots = calloc (size, sizeof (g_file_t *));
+    if (!slots)
+        return FALSE;
+
+    for (i = 0; i < files->size; i++)
+    {
+        size_t pos;
+        if (!old[i])
+            continue;
+        pos = ISTR (old[i]->name)->hash & (size - 1);
+        while (slots[pos])
+            pos = (pos + 1) & (size - 1);
+        slots[pos] = old[i];
+    }
+
+    free (old);
+    files->slots = slots;
+    files->size = size;
+    return TRUE;
+}
+
+/**
+ * Looks up the g_node_t with the passed name for get_definition_node().
+ *
+ * \param graph The graph to get the node from.
+ * \param name The NUL-terminated name to check for.
+ * \param filename The definition filename.
+ * \return A g_node_t with the name or NULL if none was found.
+ */
+static g_node_t*
+find_definition_node (graph_t *graph, char *name, char *filename)
+{
+    g_node_t **slot = NULL;
+    g_node_t *cur = NULL;
+
+    /* A name, which was never interned, cannot belong to a node. */
+    name = strtab_lookup (&graph->strings, name);
+    if (!name)
         return NULL;
+
+    slot = lookup_index (&graph->index, name);
+    cur = (slot) ? *slot : NULL;
+    while (cur)
+    {
+        if (!cur->private || cur->file == filename ||
+            strcmp (cur->file, filename) == 0)
+            return cur;
+        cur = cur->samename;
     }
-    add->next = NULL;
+    return NULL;
+}
 
-    /* First node. */
-    if (!list)
-        return add;
-     
-    /* Get to the end of the list. */
-    tmp = list;
-    while (tmp->next)
-        tmp = tmp->next;
-    tmp->next = add;
-    return list;
+/**
+ * Gets the g_node_t from the graph, that has the passed name. Private
+ * (static) nodes are only taken into account, if they were defined
+ * within the passed file.
+ *
+ * \param graph The graph to get the node from.
+ * \param name The NUL-terminated name to check for.
+ * \param filename The definition filename.
+ * \return A g_node_t with the name or NULL if none was found.
+ */
+g_node_t*
+get_definition_node (graph_t *graph, char *name, char *filename)
+{
+    g_node_t *node;
+    double start;
+
+    if (!graph->stats)
+        return find_definition_node (graph, name, filename);
+
+    start = stats_time ();
+    node = find_definition_node (graph, name, filename);
+    graph->stats->total.lookuptime += stats_time () - start;
+    graph->stats->total.lookups++;
+    return node;
 }
 
 /**
- * Frees a list of node_t nodes.
+ * Sets the root function of the graph. Like for the nodes, which are
+ * added to the graph, the last definition with the name becomes the root
+ * node.
  *
- * \param list The list of nodes to free.
+ * \param graph The graph to set the root function for.
+ * \param root The name of the root function.
  */
 void
-free_nodes (node_t *list)
+set_graph_root (graph_t *graph, const char *root)
 {
-    node_t *cur = list;
-    node_t *tmp = NULL;
+    g_node_t **slot = NULL;
+    g_node_t *cur = NULL;
+    char *name;
 
-    while (cur)
+    graph->root = root;
+    graph->rootnode = NULL;
+    if (graph->index.size)
+    {
+        name = strtab_lookup (&graph->strings, root);
+        slot = (name) ? lookup_index (&graph->index, name) : NULL;
+        for (cur = (slot) ? *slot : NULL; cur; cur = cur->samename)
+            graph->rootnode = cur;
+    }
+    else
     {
-        tmp = cur->next;
-        free (cur->name);
-        free (cur);
-        cur = tmp;
+        /* Graphs loaded from a database do not have an index. */
+        for (cur = graph->defines; cur; cur = cur->next)
+        {
+            if (strcmp (cur->name, root) == 0)
+                graph->rootnode = cur;
+        }
     }
 }
 
@@ -257,11 +746,10 @@ add_g_node (graph_t *graph, NodeType ntype, char *name, char *type, char *file,
             int line)
 {
     g_node_t *add = NULL;
-    g_node_t *tmp = graph->defines;
 
     if (line != -1)
     {
-        add = get_definition_node (graph->defines, name, file);
+        add = get_definition_node (graph, name, file);
         if (add && add->line == -1)
         {
             /* Node was created from a call earlier. Set its type and
@@ -269,46 +757,47 @@ add_g_node (graph_t *graph, NodeType ntype, char *name, char *type, char *file,
             add->line = line;
             if (type && !add->type)
             {
-                add->type = strdup (type);
+                add->type = strtab_intern (&graph->strings, type);
                 if (!add->type)
                     return NULL;
             }
             if (file)
             {
-                if (add->file)
-                    free (add->file);
-                add->file = strdup (file);
+                add->file = strtab_intern (&graph->strings, file);
                 if (!add->file)
                     return NULL;
             }
             add->ntype = ntype;
+            if (graph->curfile && !push_node (&graph->curfile->nodes, add))
+                return NULL;
             return add;
         }
     }
      
-    add = create_g_node (name, type, file, line);
+    add = create_g_node (graph, name, type, file, line);
     if (!add)
         return NULL;
     add->ntype = ntype;
 
+    if (!add_to_index (graph, add))
+        return NULL;
+
     if (strcmp (name, graph->root) == 0)
         graph->rootnode = add;
 
     /* Increase the amount of existing nodes. */
-    graph->defcount++;
+    add->id = graph->defcount++;
+    graph->csr.valid = FALSE;
 
-    /* First node. */
     if (!graph->defines)
-    {
-        graph->defines = add;
-        return add;
-    }
-
-    /* Get to the end of the list. */
-    while (tmp && tmp->next)
-        tmp = tmp->next;
-    tmp->next = add;
+        graph->defines = add; /* First node. */
+    else
+        graph->lastdefine->next = add;
+    add->prev = graph->lastdefine;
+    graph->lastdefine = add;
 
+    if (graph->curfile && !push_node (&graph->curfile->nodes, add))
+        return NULL;
     return add;
 }
 
@@ -325,207 +814,527 @@ bool_t
 add_to_call_stack (graph_t *graph, char *function, char *filename,
     g_subnode_t *calls)
 {
-    bool_t hascaller = FALSE;
-    g_subnode_t *plist = NULL;
+    int added;
     g_subnode_t *tmp = NULL;
-    g_subnode_t *unlink = NULL;
     g_subnode_t *prev = NULL;
-    g_node_t *parent = get_definition_node (graph->defines, function, filename);
+    g_nodes_t *parents = NULL;
+    g_node_t *parent = get_definition_node (graph, function, filename);
 
     if (!graph->complete)
     {
-        /* We do not want to see redundant functions. Remove them from the
-         * passed call stack. */
+        /* We do not want to see redundant functions. Remove those from
+         * the passed call stack, which are already in the call list of
+         * the parent or occur multiple times within the call stack. */
         tmp = calls;
         while (tmp)
         {
-            prev = tmp;
-            unlink = NULL;
-            plist = tmp->next;
-            while (plist)
+            added = add_edge (&graph->calls, parent, tmp->content);
+            if (added < 0)
             {
-                if (tmp->content == plist->content ||
-                    strcmp (tmp->content->name, plist->content->name) == 0)
-                {
-                    unlink = plist;
-                    break;
-                }
-                prev = plist;
-                plist = plist->next;
-            }
-
-            if (unlink)
-            {
-                prev->next = unlink->next;
-                free (unlink);
+                fprintf (stderr, "Memory allocation error\n");
+                return FALSE;
             }
-            tmp = tmp->next;
-        }
-        
-        /* Now eliminate those, which are already in the call list of
-         * the parent. */
-        plist = parent->list;
-        while (plist)
-        {
-            tmp = calls;
-            prev = NULL;
-            while (tmp)
+            if (added)
             {
-                if (tmp->content == plist->content ||
-                    strcmp (tmp->content->name, plist->content->name) == 0)
-                {
-                    if (tmp == calls)
-                        calls = tmp->next;
-                    if (prev)
-                        prev->next = tmp->next;
-                    unlink = tmp;
-                    tmp = tmp->next;
-                    free (unlink);
-                }
-                else
-                {
-                    prev = tmp;
-                    tmp = tmp->next;
-                }
+                prev = tmp;
+                tmp = tmp->next;
+                continue;
             }
-            plist = plist->next;
+
+            if (prev)
+                prev->next = tmp->next;
+            else
+                calls = tmp->next;
+            if (graph->stats)
+                graph->stats->total.duplicates++;
+
+            /* Keep the subnode for reuse. */
+            tmp->next = graph->freesubs;
+            graph->freesubs = tmp;
+            tmp = (prev) ? prev->next : calls;
         }
     }
 
     /* The callees need to know about their caller. */
-    tmp = calls;
-    while (tmp)
+    for (tmp = calls; tmp; tmp = tmp->next)
     {
-        if (!tmp->content->callers)
-        {
-            tmp->content->callers = create_sub_node (parent);
-            if (!tmp->content->callers)
-            {
-                fprintf (stderr, "Memory alloation error\n");
-                return FALSE;
-            }
-            tmp = tmp->next;
-            continue;
-        }
+        g_subnode_t *sub = NULL;
 
-        plist = tmp->content->callers;
-        hascaller = FALSE;
-        while (plist->next)
+        added = add_edge (&graph->callers, tmp->content, parent);
+        if (added < 0)
         {
-            if (plist->content == parent)
-            {
-                hascaller = TRUE;
-                break;
-            }
-            plist = plist->next;
+            fprintf (stderr, "Memory allocation error\n");
+            return FALSE;
         }
+        if (!added)
+            continue;
 
-        if (!hascaller)
+        sub = create_sub_node (graph, parent);
+        if (!sub)
         {
-            plist->next = create_sub_node (parent);
-            if (!plist->next)
-            {
-                fprintf (stderr, "Memory allocation error\n");
-                return FALSE;
-            }
+            fprintf (stderr, "Memory allocation error\n");
+            return FALSE;
         }
+        sub->owner = filename;
+        if (tmp->content->callers)
+            tmp->content->callerstail->next = sub;
+        else
+            tmp->content->callers = sub;
+        tmp->content->callerstail = sub;
+        tmp->content->changed = TRUE;
+    }
+
+    if (!calls)
+        return TRUE;
+
+    graph->csr.valid = FALSE;
+    parent->changed = TRUE;
+    if (parent->list)
+        parent->listtail->next = calls;
+    else
+        parent->list = calls;
+
+    /* Get to the new end of the call list. */
+    tmp = calls;
+    tmp->owner = filename;
+    added = 1;
+    while (tmp->next)
+    {
         tmp = tmp->next;
+        tmp->owner = filename;
+        added++;
     }
+    parent->listtail = tmp;
+    if (graph->stats)
+        graph->stats->total.edges += (size_t) added;
 
-    plist = parent->list;
-    if (plist)
+    /* Remember the parent for retract_file(). */
+    parents = (graph->curfile) ? &graph->curfile->parents : NULL;
+    if (parents && (!parents->count ||
+        parents->nodes[parents->count - 1] != parent) &&
+        !push_node (parents, parent))
     {
-        while (plist->next)
-            plist = plist->next;
-        plist->next = calls;
+        fprintf (stderr, "Memory allocation error\n");
+        return FALSE;
     }
-    else
-        parent->list = calls;
     return TRUE;
 }
 
 /**
- * Frees a list of g_node_t nodes.
+ * Gets the record of an input file of the graph and creates it, if it
+ * does not exist yet. The records are numbered in the order of their
+ * creation, which is the order of the input files.
  *
- * \param list The list of nodes to free.
+ * \param graph The graph to get the record from.
+ * \param name The name of the file, which is interned in the string
+ *        table of the graph.
+ * \return The g_file_t of the file or NULL in case of an error.
  */
-void
-free_g_nodes (g_node_t *list)
+g_file_t*
+add_graph_file (graph_t *graph, char *name)
 {
-    g_node_t *cur = list;
-    g_node_t *tmp = NULL;
+    g_files_t *files = &graph->files;
+    g_file_t **slot = NULL;
+    g_file_t *file = NULL;
 
-    while (cur)
+    slot = lookup_file (files, name);
+    if (slot && *slot)
+        return *slot;
+
+    if ((files->used + 1) * 2 > files->size)
     {
-        tmp = cur->next;
-        free_g_node (cur);
-        cur = tmp;
+        if (!grow_files (files))
+            return NULL;
+        slot = lookup_file (files, name);
     }
+    file = arena_alloc (&graph->arena, sizeof (g_file_t));
+    if (!file)
+        return NULL;
+    memset (file, 0, sizeof (g_file_t));
+    file->name = name;
+    file->index = (int) files->used;
+    *slot = file;
+    files->used++;
+    return file;
 }
 
 /**
- * Frees a graph_t.
+ * Gets the record of an input file of the graph.
  *
- * \param graph The graph_t to free.
+ * \param graph The graph to get the record from.
+ * \param filename The name of the file.
+ * \return The g_file_t of the file or NULL, if the file was not added
+ *         to the graph.
  */
-void
-free_graph (graph_t *graph)
+g_file_t*
+get_graph_file (graph_t *graph, const char *filename)
 {
-    free_nodes (graph->excludes);
-    free_g_nodes (graph->defines);
-    free (graph);
+    g_file_t **slot = NULL;
+    char *name = strtab_lookup (&graph->strings, filename);
+
+    slot = (name) ? lookup_file (&graph->files, name) : NULL;
+    return (slot) ? *slot : NULL;
+}
+
+/**
+ * Keeps a subnode, which was removed from its list, for reuse.
+ *
+ * \param graph The graph the subnode belongs to.
+ * \param sub The g_subnode_t to release.
+ */
+static void
+release_sub_node (graph_t *graph, g_subnode_t *sub)
+{
+    sub->next = graph->freesubs;
+    sub->content = NULL;
+    sub->owner = NULL;
+    graph->freesubs = sub;
+}
+
+/**
+ * Removes a node, which has neither calls nor callers, from the graph.
+ * The node is kept for reuse by create_g_node().
+ *
+ * \param graph The graph to remove the node from.
+ * \param node The g_node_t to remove.
+ */
+static void
+remove_node (graph_t *graph, g_node_t *node)
+{
+    if (node->prev)
+        node->prev->next = node->next;
+    else
+        graph->defines = node->next;
+    if (node->next)
+        node->next->prev = node->prev;
+    else
+        graph->lastdefine = node->prev;
+    remove_from_index (graph, node);
+
+    node->id = REMOVED_NODE;
+    node->file = NULL;
+    node->samename = NULL;
+    node->prev = NULL;
+    node->next = graph->freenodes;
+    graph->freenodes = node;
+    graph->defcount--;
+    graph->csr.valid = FALSE;
+
+    if (graph->rootnode == node)
+        set_graph_root (graph, graph->root);
+}
+
+/**
+ * Removes a node, which is undefined and has neither calls nor callers
+ * anymore, from the graph.
+ *
+ * \param graph The graph to remove the node from.
+ * \param node The g_node_t to check.
+ */
+static void
+remove_unused_node (graph_t *graph, g_node_t *node)
+{
+    if (node->id != REMOVED_NODE && node->line == -1 && !node->list &&
+        !node->callers)
+        remove_node (graph, node);
 }
 
 /**
- * Adds both, specific types and keywords (like function definitions) to
- * the static exclude lists. This will ensure, that the user can
- * 'filter' the wanted output with some limited mechanisms.
- *  The caller has to free the exclude list
+ * Removes a caller from the caller list of a node.
  *
- * \param excludes The excludes to add the keywords to.
- * \param keywords An array of keywords to add to the excludes.
+ * \param graph The graph the node belongs to.
+ * \param node The g_node_t to remove the caller from.
+ * \param caller The calling g_node_t to remove.
+ */
+static void
+unlink_caller (graph_t *graph, g_node_t *node, g_node_t *caller)
+{
+    g_subnode_t *prev = NULL;
+    g_subnode_t *sub = node->callers;
+
+    while (sub && sub->content != caller)
+    {
+        prev = sub;
+        sub = sub->next;
+    }
+    if (!sub)
+        return;
+
+    if (prev)
+        prev->next = sub->next;
+    else
+        node->callers = sub->next;
+    if (node->callerstail == sub)
+        node->callerstail = prev;
+    node->changed = TRUE;
+    release_sub_node (graph, sub);
+}
+
+/**
+ * Removes the edges of a call, which was removed from the call list of
+ * its parent, and releases the call. The called node is removed, if it
+ * is undefined and not used anymore.
  *
- * \return The new start of the excludes list or NULL in case of an
- *         error. If NULL is returned, the passed excludes are freed
- *         automatically.
+ * \param graph The graph the call belongs to.
+ * \param parent The g_node_t, the call was removed from.
+ * \param sub The removed g_subnode_t.
  */
-static inline node_t*
-add_excludes (node_t *excludes, const char* keywords[])
+static void
+drop_call (graph_t *graph, g_node_t *parent, g_subnode_t *sub)
 {
-    const char **cur;
-    node_t *list = excludes;
+    g_node_t *callee = sub->content;
+    g_subnode_t *cur = NULL;
 
-    for (cur = keywords; *cur != NULL; cur++)
+    if (!graph->complete)
+        remove_edge (&graph->calls, parent, callee);
+    else
     {
-        list = add_node (list, *cur);
-        if (!list)
+        /* The parent may call the callee several times, each of those
+         * calls keeps the parent as caller. */
+        for (cur = parent->list; cur; cur = cur->next)
         {
-            free_nodes (excludes);
-            return NULL;
+            if (cur->content == callee)
+                break;
+        }
+    }
+    if (!cur)
+    {
+        remove_edge (&graph->callers, callee, parent);
+        unlink_caller (graph, callee, parent);
+    }
+    release_sub_node (graph, sub);
+    remove_unused_node (graph, callee);
+    graph->csr.valid = FALSE;
+}
+
+/**
+ * Removes the calls and references, a file added to a node.
+ *
+ * \param graph The graph the node belongs to.
+ * \param parent The g_node_t to remove the calls from.
+ * \param file The interned name of the file.
+ */
+static void
+retract_calls (graph_t *graph, g_node_t *parent, const char *file)
+{
+    g_subnode_t *removed = NULL;
+    g_subnode_t **link = &parent->list;
+    g_subnode_t *sub = NULL;
+    g_subnode_t *next = NULL;
+
+    parent->listtail = NULL;
+    for (sub = parent->list; sub; sub = next)
+    {
+        next = sub->next;
+        if (sub->owner == file)
+        {
+            sub->next = removed;
+            removed = sub;
+            continue;
         }
+        *link = sub;
+        link = &sub->next;
+        parent->listtail = sub;
+    }
+    *link = NULL;
+    if (removed)
+        parent->changed = TRUE;
+
+    for (sub = removed; sub; sub = next)
+    {
+        next = sub->next;
+        drop_call (graph, parent, sub);
     }
-    return list;
 }
 
 /**
- * Creates the statically kept exclude lists based on the user input.
+ * Removes everything, a file added to the graph, so that the file can be
+ * processed again. The calls and references of the file are removed.
+ * Nodes, which were created by the file and are not used anymore, are
+ * removed as well, while definitions of the file, which are still called
+ * by other files, become undefined function nodes again, as if they were
+ * only created by a call. The files after the file have to be removed
+ * beforehand, since they may refer to its definitions (see
+ * update_graph()). Only the nodes and calls, which are kept in the record
+ * of the file, are visited.
  *
- * \param list The list to add the excludes to.
+ * \param graph The graph to remove the file from.
+ * \param filename The name of the file to remove.
+ * \return TRUE on success, FALSE on error.
+ */
+bool_t
+retract_file (graph_t *graph, const char *filename)
+{
+    g_file_t *rec = NULL;
+    g_file_t *other = NULL;
+    g_node_t *cur = NULL;
+    char *owner = NULL;
+    size_t kept = 0;
+    size_t i;
+
+    if (graph->csr.mapped)
+    {
+        fprintf (stderr, "%s: A loaded graph database cannot be updated\n",
+            filename);
+        return FALSE;
+    }
+
+    /* A file without a record did not add anything. */
+    rec = get_graph_file (graph, filename);
+    if (!rec)
+        return TRUE;
+
+    unique_nodes (&rec->parents);
+    for (i = 0; i < rec->parents.count; i++)
+        retract_calls (graph, rec->parents.nodes[i], rec->name);
+    rec->parents.count = 0;
+
+    unique_nodes (&rec->nodes);
+    for (i = 0; i < rec->nodes.count; i++)
+    {
+        cur = rec->nodes.nodes[i];
+        if (cur->id == REMOVED_NODE || cur->file != rec->name)
+            continue;
+        if (!cur->list && !cur->callers)
+        {
+            /* Unused node of the file. */
+            remove_node (graph, cur);
+            continue;
+        }
+
+        /* Still called by other files, keep it as undefined node of one
+         * of them. */
+        cur->line = -1;
+        cur->type = NULL;
+        cur->ntype = FUNCTION;
+        cur->private = FALSE;
+        owner = (cur->callers) ? cur->callers->owner : cur->list->owner;
+        other = (owner != rec->name) ? get_graph_file (graph, owner) : NULL;
+        if (!other)
+        {
+            rec->nodes.nodes[kept++] = cur;
+            continue;
+        }
+        cur->file = owner;
+        if (!push_node (&other->nodes, cur))
+            goto memerror;
+    }
+    rec->nodes.count = kept;
+    graph->csr.valid = FALSE;
+    return TRUE;
+
+memerror:
+    fprintf (stderr, "Memory allocation error\n");
+    return FALSE;
+}
+
+/**
+ * Initializes a graph_t with its default values.
+ *
+ * \param graph The graph_t to initialize.
+ */
+void
+init_graph (graph_t *graph)
+{
+    keywords_init ();
+    scan_init ();
+    graph->excludes = 0;
+    graph->defines = NULL;
+    graph->lastdefine = NULL;
+    graph->index.slots = NULL;
+    graph->index.size = 0;
+    graph->index.used = 0;
+    init_edgeset (&graph->calls, TRUE);
+    init_edgeset (&graph->callers, FALSE);
+    arena_init (&graph->arena);
+    strtab_init (&graph->strings, &graph->arena);
+    graph->freesubs = NULL;
+    graph->freenodes = NULL;
+    graph->files.slots = NULL;
+    graph->files.size = 0;
+    graph->files.used = 0;
+    graph->curfile = NULL;
+    init_csr (&graph->csr);
+    source_init_buffer (&graph->db, NULL, 0);
+    graph->stats = NULL;
+    graph->defcount = 0;
+    graph->statics = FALSE;
+    graph->privates = FALSE;
+    graph->depth = INT_MAX;
+    graph->root = "main";
+    graph->rootnode = NULL;
+    graph->complete = FALSE;
+    graph->reversed = FALSE;
+}
+
+/**
+ * Frees the contents of a graph_t, but not the graph_t itself.
+ *
+ * \param graph The graph_t to clear.
+ */
+void
+clear_graph (graph_t *graph)
+{
+    size_t i;
+
+    thaw_graph (graph);
+    for (i = 0; i < graph->files.size; i++)
+    {
+        if (!graph->files.slots[i])
+            continue;
+        free (graph->files.slots[i]->nodes.nodes);
+        free (graph->files.slots[i]->parents.nodes);
+    }
+    free (graph->files.slots);
+    free (graph->index.slots);
+    free (graph->calls.slots);
+    free (graph->callers.slots);
+    strtab_free (&graph->strings);
+    arena_free (&graph->arena);
+    source_close (&graph->db);
+    source_init_buffer (&graph->db, NULL, 0);
+    graph->excludes = 0;
+    graph->defines = NULL;
+    graph->lastdefine = NULL;
+    graph->index.slots = NULL;
+    graph->index.size = 0;
+    graph->index.used = 0;
+    init_edgeset (&graph->calls, TRUE);
+    init_edgeset (&graph->callers, FALSE);
+    graph->freesubs = NULL;
+    graph->freenodes = NULL;
+    graph->files.slots = NULL;
+    graph->files.size = 0;
+    graph->files.used = 0;
+    graph->curfile = NULL;
+    graph->defcount = 0;
+    graph->rootnode = NULL;
+}
+
+/**
+ * Frees a graph_t.
+ *
+ * \param graph The graph_t to free.
+ */
+void
+free_graph (graph_t *graph)
+{
+    clear_graph (graph);
+    free (graph);
+}
+
+/**
+ * Sets the excluded keywords of the graph based on the user input. The
+ * excluded keywords are recognized using keyword_class().
+ *
+ * \param graph The graph to add the excludes to.
  * \param excludes The type of excludes to add.
- * \return The updated excludes list or NULL in case of an error. If
- *         NULL is returned, the passed excludes are freed
- *         automatically.
- */
-node_t*
-create_excludes (node_t *list, int excludes)
-{
-    if ((excludes & NO_ANSI_KWDS) == NO_ANSI_KWDS)
-        list = add_excludes (list, ansi_keywords);
-    if ((excludes & NO_POSIX_KWDS) == NO_POSIX_KWDS)
-        list = add_excludes (list, posix_keywords);
-    if ((excludes & NO_C99_KWDS) == NO_C99_KWDS)
-        list = add_excludes (list, c99_keywords);
-    if ((excludes & NO_GCC_KWDS) == NO_GCC_KWDS)
-        list = add_excludes (list, gcc_keywords);
-    return list;
+ * \return TRUE on success, FALSE in case of an error.
+ */
+bool_t
+create_excludes (graph_t *graph, int excludes)
+{
+    graph->excludes |= excludes & (NO_ANSI_KWDS | NO_POSIX_KWDS |
+        NO_C99_KWDS | NO_GCC_KWDS);
+    return TRUE;
 }
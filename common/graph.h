@@ -30,6 +30,7 @@
 #ifndef GRAPH_H
 #define GRAPH_H
 
+#include <stddef.h>
 #include <stdio.h>
 #ifdef WIN32
 #include "wincompat.h"
@@ -40,12 +41,61 @@ typedef int bool_t;
 #define FALSE (0)
 #define TRUE (!FALSE)
 
-/* Node lists. */
-typedef struct _node
+/* Arena for the memory of a graph. Allocations are taken from large
+ * blocks and released all at once, when the arena is freed.
+ */
+typedef struct _arena
+{
+    struct _arena_block *blocks; /* Allocated blocks. */
+    char                *cur;    /* Free space within the current block. */
+    char                *end;    /* End of the current block. */
+} arena_t;
+
+/* An interned string. The string data directly follows the header, so
+ * that the header can be retrieved from the string using ISTR().
+ */
+typedef struct _istr
+{
+    unsigned int hash;    /* Hash value of the string. */
+    int          len;     /* Length of the string. */
+    char         str[1];  /* The NUL-terminated string. */
+} istr_t;
+
+#define ISTR(s) ((istr_t *) ((char *) (s) - offsetof (istr_t, str)))
+
+/* Table of interned strings. */
+typedef struct _strtab
+{
+    arena_t    *arena;    /* Arena to allocate the strings from. */
+    istr_t    **slots;    /* The hash slots. */
+    size_t      size;     /* Amount of slots, always a power of two. */
+    size_t      used;     /* Amount of occupied slots. */
+} strtab_t;
+
+/* Contents of an input file, kept in memory for scanning. Regular files
+ * are mapped into memory, other files like pipes are read completely.
+ * Buffers of the caller can be scanned using source_init_buffer().
+ */
+typedef struct _source
+{
+    char       *data;     /* The file contents, not NUL-terminated. */
+    size_t      len;      /* Length of the contents. */
+    const char *cur;      /* Current read position within the contents. */
+    const char *end;      /* End of the contents. */
+    bool_t      mapped;   /* Indicates, whether the contents are mapped. */
+    bool_t      owned;    /* Indicates, whether source_close() releases
+                           * the contents. */
+} source_t;
+
+/* Buffered output, which is written to a file descriptor. */
+typedef struct _output
 {
-    struct _node *next; /* Pointer to next one in list. */
-    char         *name; /* Name of the current node. */
-} node_t;
+    char       *buf;      /* The buffered data. */
+    size_t      len;      /* Length of the buffered data. */
+    size_t      size;     /* Size of the buffer. */
+    int         fd;       /* The file descriptor to write to. */
+    bool_t      error;    /* Indicates, whether writing failed. */
+} output_t;
 
 typedef enum 
 {
@@ -61,16 +111,25 @@ typedef enum
 typedef struct _g_node
 {
     struct _g_node    *next;    /* Pointer to next main node in list. */
+    struct _g_node    *prev;    /* Pointer to previous main node in list. */
+    struct _g_node    *samename; /* Next main node with the same name. */
     struct _g_subnode *list;    /* Calls within the function. */
+    struct _g_subnode *listtail; /* Last entry of the calls. */
     struct _g_subnode *callers; /* Callers of the function. */
+    struct _g_subnode *callerstail; /* Last entry of the callers. */
+    long int           id;      /* Index within the frozen graph. */
     char              *name;    /* Name of the current node. */
     int                namelen; /* Length of the name. */
+    int                line;    /* Line where defined, not declared. */
     char              *type;    /* Type of the current node. */
     char              *file;    /* Definition/declaration file. */
-    int                line;    /* Line where defined, not declared. */
     NodeType           ntype;   /* Type of the node. */
     bool_t             private; /* Indicates the scope of that node. */
     bool_t             printed; /* Indicates, whether the node was printed. */
+    bool_t             changed; /* Indicates, whether the calls or callers
+                                 * changed since the graph was frozen. */
+    long int           scc;     /* Recursion group of the node or -1, which
+                                 * is set by find_cycles(). */
 } g_node_t;
 
 /* To conserve space for the directed graph we use a subnode definition
@@ -81,13 +140,147 @@ typedef struct _g_subnode
 {
     struct _g_subnode *next;    /* The next node in the list. */
     struct _g_node    *content; /* The according g_node_t for this entry. */
+    char              *owner;   /* The file, which added the entry. */
 } g_subnode_t;
 
+/* Hash index over the definitions of a graph. The index uses open
+ * addressing and keeps the first definition of a certain name in its
+ * slot. Further definitions with the same name (e.g. static functions
+ * within different files) are chained using the samename member of the
+ * g_node_t in the order of their creation.
+ */
+typedef struct _g_index
+{
+    g_node_t  **slots;    /* The hash slots. */
+    size_t      size;     /* Amount of slots, always a power of two. */
+    size_t      used;     /* Amount of occupied slots. */
+} g_index_t;
+
+/* An edge between two nodes of the graph. */
+typedef struct _g_edge
+{
+    struct _g_node *from;     /* The node the edge starts at. */
+    struct _g_node *to;       /* The node the edge points to. */
+} g_edge_t;
+
+/* Open addressing hash set of the edges of a graph, used to check for
+ * already existing calls and callers of a function.
+ */
+typedef struct _g_edgeset
+{
+    g_edge_t   *slots;    /* The hash slots. */
+    size_t      size;     /* Amount of slots, always a power of two. */
+    size_t      used;     /* Amount of occupied slots. */
+    bool_t      byname;   /* Compare the target nodes by their name. */
+} g_edgeset_t;
+
+/* Growable array of nodes. */
+typedef struct _g_nodes
+{
+    g_node_t  **nodes;    /* The nodes. */
+    size_t      count;    /* Amount of nodes. */
+    size_t      size;     /* Amount of allocated nodes. */
+} g_nodes_t;
+
+/* The nodes and calls, an input file added to the graph, so that
+ * retract_file() only needs to visit those. The records are kept for
+ * all files, which were added to the graph.
+ */
+typedef struct _g_file
+{
+    char       *name;     /* Interned name of the file. */
+    int         index;    /* Position of the file within the input files. */
+    g_nodes_t   nodes;    /* Nodes created or defined by the file. */
+    g_nodes_t   parents;  /* Nodes, the file added calls to. */
+} g_file_t;
+
+/* Open addressing hash table of the file records of a graph, which uses
+ * the interned names as keys.
+ */
+typedef struct _g_files
+{
+    g_file_t  **slots;    /* The hash slots. */
+    size_t      size;     /* Amount of slots, always a power of two. */
+    size_t      used;     /* Amount of occupied slots. */
+} g_files_t;
+
+/* 32-bit index of a node within the frozen graph, which matches the id
+ * of the node.
+ */
+typedef unsigned int g_id_t;
+
+/* Frozen, compact form of a graph in a compressed sparse row layout.
+ * The calls of the node i are the nodes callids[calloffs[i]] up to
+ * callids[calloffs[i + 1] - 1] in the order of the call list, the same
+ * applies to the callers. The printers and analyses operate on this
+ * form, which is created by freeze_graph().
+ */
+typedef struct _g_csr
+{
+    g_node_t  **nodes;     /* The nodes, indexed by their id. */
+    g_id_t     *calloffs;  /* Offsets of the calls of each node. */
+    g_id_t     *callids;   /* Called nodes. */
+    g_id_t     *calleroffs; /* Offsets of the callers of each node. */
+    g_id_t     *callerids; /* Calling nodes. */
+    int        *sublen;    /* Longest name of the calls of each node. */
+    g_id_t      count;     /* Amount of nodes. */
+    bool_t      valid;     /* Indicates, whether the graph was not
+                            * modified since it was frozen. */
+    bool_t      mapped;    /* Indicates, whether the offsets, ids and
+                            * lengths belong to a loaded graph database. */
+} g_csr_t;
+
+/* Statistics of the processing of a single file or of all files. */
+typedef struct _filestats
+{
+    const char *file;        /* The name of the file or NULL. */
+    bool_t      cached;      /* Indicates, whether the log was cached. */
+    double      lextime;     /* Seconds spent lexing. */
+    double      buildtime;   /* Seconds spent adding the operations to the
+                              * graph, including the lookups. */
+    double      lookuptime;  /* Seconds spent looking up definitions. */
+    size_t      tokens;      /* Amount of tokens. */
+    size_t      identifiers; /* Amount of identifiers. */
+    size_t      definitions; /* Amount of definitions. */
+    size_t      nodes;       /* Amount of created nodes. */
+    size_t      edges;       /* Amount of added calls and references. */
+    size_t      duplicates;  /* Amount of dropped duplicate calls and
+                              * references. */
+    size_t      lookups;     /* Amount of definition lookups. */
+} filestats_t;
+
+/* Run-time statistics of a run. The graph functions update the totals,
+ * while the statistics of the files are taken from the differences of
+ * the totals.
+ */
+typedef struct _stats
+{
+    filestats_t  total;      /* Totals of all files. */
+    filestats_t *files;      /* Statistics of the single files. */
+    size_t       count;      /* Amount of files. */
+    size_t       size;       /* Amount of allocated files. */
+    double       printtime;  /* Seconds spent printing. */
+    double       start;      /* Start of the run. */
+} stats_t;
+
 /* File struct for graphs. */
 typedef struct _graph
 {
-    node_t     *excludes; /* Excluded keywords. */
+    int         excludes; /* Excluded keyword classes (NO_*_KWDS). */
     g_node_t   *defines;  /* Associated definition list. */
+    g_node_t   *lastdefine; /* Last entry of the definition list. */
+    g_index_t   index;    /* Name index for the definition list. */
+    g_edgeset_t calls;    /* Function -> callee edges (by callee name). */
+    g_edgeset_t callers;  /* Callee -> function edges. */
+    arena_t     arena;    /* Memory for the nodes, subnodes and names. */
+    strtab_t    strings;  /* Interned names, types and files. */
+    g_subnode_t *freesubs; /* Released subnodes for reuse. */
+    g_node_t   *freenodes; /* Released nodes for reuse. */
+    g_files_t   files;    /* Records of the input files. */
+    g_file_t   *curfile;  /* Record of the file, which is replayed. */
+    g_csr_t     csr;      /* Frozen form of the graph. */
+    source_t    db;       /* Graph database, the graph was loaded from. */
+    stats_t    *stats;    /* Statistics to update or NULL. */
     long int    defcount; /* Amount of defines. */
     bool_t      statics;  /* Include externals and static data (-i x). */
     bool_t      privates; /* Include data with a leading underscore (-i _). */
@@ -99,6 +292,85 @@ typedef struct _graph
     
 } graph_t;
 
+/* Operations of the lexers on a graph. The lexers do not modify the
+ * graph directly, but record the operations for a file in an oplog_t,
+ * which is replayed into the graph afterwards. Thus several files can
+ * be lexed at the same time, while the graph is still built in the
+ * order of the files.
+ */
+typedef enum
+{
+    OP_DEFINE,    /* Definition or declaration of a node. */
+    OP_CALL,      /* Call of a function, created on demand. */
+    OP_REFERENCE, /* Possible reference of a global variable. */
+    OP_FLUSH      /* End of a statement, which adds the calls and
+                   * references so far to the current function. */
+} OpType;
+
+/* A single operation of a lexer. */
+typedef struct _op
+{
+    OpType      op;       /* The kind of operation. */
+    NodeType    ntype;    /* Type of the node to define. */
+    char       *name;     /* Name of the node or the current function. */
+    char       *type;     /* Type of the node or NULL. */
+    int         line;     /* Line of the node or -1. */
+    int         private;  /* Scope of the node or -1 to keep it. */
+} op_t;
+
+/* Operation log of a lexer for a single file. The names and types of
+ * the operations are interned by the log's own string table.
+ */
+typedef struct _oplog
+{
+    char       *filename; /* Name of the file. */
+    op_t       *ops;      /* The recorded operations. */
+    size_t      count;    /* Amount of recorded operations. */
+    size_t      size;     /* Amount of allocated operations. */
+    arena_t     arena;    /* Memory for the strings. */
+    strtab_t    strings;  /* Interned names and types. */
+    size_t      tokens;   /* Amount of tokens read by the lexer. */
+    size_t      identifiers; /* Amount of identifiers among the tokens. */
+    char        error[128]; /* Error message of the lexer or empty. */
+} oplog_t;
+
+/* State of a lexer for a single source. */
+typedef struct _lexer
+{
+    source_t   *src;      /* The source to scan. */
+    oplog_t    *log;      /* The log to record the operations in. */
+    int         line;     /* Current line within the source. */
+    int         field;    /* Current field within the line (NASM). */
+    int         excludes; /* Excluded keyword classes (C). */
+} lexer_t;
+
+/* Lexer function, which records the operations for a source in a log.
+ * The data argument is passed through by create_graph().
+ */
+typedef bool_t (*lex_func_t) (oplog_t *log, source_t *src, void *data);
+
+/* Printing function, which prints a graph to a file descriptor. */
+typedef void (*print_func_t) (graph_t *graph, int fd);
+
+/* On-disk cache of the operation logs. The logs are stored by the hash of
+ * the file contents and the key, so that unchanged files do not need to
+ * be lexed again.
+ */
+typedef struct _logcache
+{
+    const char  *dir;     /* Directory of the cache files. */
+    unsigned int key;     /* The lexer and its options, which affect the
+                           * recorded operations. */
+} logcache_t;
+
+/* Cache keys of the lexers, which are combined with their options. */
+enum
+{
+    CACHE_KEY_C =    0x100,  /* C lexer, ORed with the NO_*_KWDS flags. */
+    CACHE_KEY_AS =   0x200,  /* GNU as lexer. */
+    CACHE_KEY_NASM = 0x300   /* NASM lexer. */
+};
+
 /* Keyword flags for bitwise ORs of the keywords to exclude. */
 enum
 {
@@ -108,22 +380,179 @@ enum
     NO_GCC_KWDS =   8
 };
 
+/* Keyword classes, as returned by keyword_class(). The classes of the
+ * keyword tables match the flags of the keywords to exclude.
+ */
+enum
+{
+    KWD_ANSI =     NO_ANSI_KWDS,
+    KWD_POSIX =    NO_POSIX_KWDS,
+    KWD_C99 =      NO_C99_KWDS,
+    KWD_GCC =      NO_GCC_KWDS,
+    KWD_BUILTIN =  16,   /* C keywords without relevance for the graph. */
+    KWD_STATIC =   32,
+    KWD_TYPEDEF =  64,
+    KWD_EXTERN =   128,
+    KWD_STRUCT =   256,  /* 'struct' or 'union'. */
+    KWD_ENUM =     512
+};
+
+/* Release the graph memory on exiting the applications. As the memory
+ * is kept in a few large arena blocks, this is cheap, but can be
+ * disabled nonetheless by defining FREE_GRAPH_ON_EXIT to 0.
+ */
+#ifndef FREE_GRAPH_ON_EXIT
+#define FREE_GRAPH_ON_EXIT 1
+#endif
+
+/* Arena functions, defined in arena.c. */
+void arena_init (arena_t *arena);
+void* arena_alloc (arena_t *arena, size_t size);
+char* arena_strdup (arena_t *arena, const char *str);
+void arena_free (arena_t *arena);
+
+/* String table functions, defined in strtab.c. */
+void strtab_init (strtab_t *tab, arena_t *arena);
+char* strtab_intern (strtab_t *tab, const char *str);
+char* strtab_intern_len (strtab_t *tab, const char *str, size_t len);
+char* strtab_import (strtab_t *tab, const char *str);
+char* strtab_intern_concat (strtab_t *tab, const char *first,
+                            const char *second);
+char* strtab_lookup (strtab_t *tab, const char *str);
+char* strtab_lookup_len (strtab_t *tab, const char *str, size_t len);
+size_t strtab_slot (strtab_t *tab, const char *str);
+void strtab_free (strtab_t *tab);
+
+/* Keyword functions, defined in keywords.c. */
+void keywords_init (void);
+int keyword_class (const char *name, size_t len);
+
+/* Scanning functions, defined in scan.c. */
+void scan_init (void);
+const char* scan_spaces (const char *p, const char *end, int *lines);
+const char* scan_comment (const char *p, const char *end, int *lines);
+const char* scan_string (const char *p, const char *end, int delim,
+                         int *lines);
+const char* scan_brackets (const char *p, const char *end, int *lines);
+
+/* Source functions, defined in source.c. */
+bool_t source_open (source_t *src, const char *filename);
+bool_t source_read (source_t *src, const char *filename);
+void source_init_buffer (source_t *src, const char *data, size_t len);
+void source_close (source_t *src);
+
+/**
+ * Gets the next character from a source.
+ *
+ * \param src The source to read the character from.
+ * \return The character value or EOF, if the end of the source was
+ *         reached.
+ */
+static inline int
+source_getc (source_t *src)
+{
+    if (src->cur < src->end)
+        return (unsigned char) *src->cur++;
+    return EOF;
+}
+
+/**
+ * Pushes the last character read by source_getc() back to the source.
+ *
+ * \param src The source to push the character back to.
+ * \param ch The last character read. EOF is ignored.
+ */
+static inline void
+source_ungetc (source_t *src, int ch)
+{
+    if (ch != EOF)
+        src->cur--;
+}
+
+/* Operation log functions, defined in oplog.c. */
+bool_t oplog_init (oplog_t *log, const char *filename);
+bool_t oplog_add (oplog_t *log, OpType op, NodeType ntype, char *name,
+                  char *type, int line, int private);
+void oplog_error (oplog_t *log, const char *fmt, ...);
+bool_t oplog_replay (graph_t *graph, oplog_t *log);
+void oplog_free (oplog_t *log);
+
+/* Operation log cache functions, defined in cache.c. */
+unsigned long long cache_hash (source_t *src);
+bool_t cache_check (const logcache_t *cache);
+bool_t cache_load (const logcache_t *cache, source_t *src,
+                   unsigned long long hash, oplog_t *log);
+void cache_store (const logcache_t *cache, source_t *src,
+                  unsigned long long hash, oplog_t *log);
+
+/* File processing functions, defined in jobs.c. */
+bool_t create_graph (graph_t *graph, char **files, int count, int jobs,
+                     lex_func_t lex, void *data, const logcache_t *cache);
+bool_t update_graph (graph_t *graph, char **files, int count, int jobs,
+                     lex_func_t lex, void *data, const logcache_t *cache,
+                     int *failed);
+
 /* Graph functions, defined in graph.c. */
-node_t* add_node (node_t *list, const char *name);
-g_subnode_t *create_sub_node (g_node_t *node);
-g_node_t* create_g_node (char *name, char *type, char *file, int line);
-g_node_t* get_definition_node (g_node_t *list, char *name, char *filename);
+g_subnode_t *create_sub_node (graph_t *graph, g_node_t *node);
+g_node_t* create_g_node (graph_t *graph, char *name, char *type, char *file,
+                         int line);
+g_node_t* get_definition_node (graph_t *graph, char *name, char *filename);
 g_node_t* add_g_node (graph_t *graph, NodeType ntype, char *name, char* type,
                       char *file, int line);
 bool_t add_to_call_stack (graph_t *graph, char *function, char *filename,
                           g_subnode_t *calls);
-void free_nodes (node_t *list);
-void free_g_nodes (g_node_t *list);
+g_file_t* add_graph_file (graph_t *graph, char *name);
+g_file_t* get_graph_file (graph_t *graph, const char *filename);
+bool_t retract_file (graph_t *graph, const char *filename);
+void set_graph_root (graph_t *graph, const char *root);
+void init_graph (graph_t *graph);
+void clear_graph (graph_t *graph);
 void free_graph (graph_t *graph);
-node_t* create_excludes (node_t *list, int excludes);
+bool_t create_excludes (graph_t *graph, int excludes);
+
+/* Output functions, defined in output.c. */
+bool_t output_init (output_t *out, int fd);
+bool_t output_flush (output_t *out);
+bool_t output_close (output_t *out);
+void output_write (output_t *out, const char *data, size_t len);
+void output_puts (output_t *out, const char *str);
+void output_putc (output_t *out, int ch);
+void output_str (output_t *out, const char *str, size_t len, int width);
+void output_int (output_t *out, long val, int width);
+
+/* Frozen graph functions, defined in csr.c. */
+void init_csr (g_csr_t *csr);
+bool_t freeze_graph (graph_t *graph);
+void thaw_graph (graph_t *graph);
+
+/* Statistics functions, defined in stats.c. */
+void stats_init (stats_t *stats);
+void stats_free (stats_t *stats);
+double stats_time (void);
+bool_t stats_add_file (stats_t *stats, const filestats_t *file);
+bool_t write_stats (stats_t *stats, const char *program, int jobs,
+                    const char *filename);
+
+/* Graph database functions, defined in graphdb.c. */
+bool_t save_graph_db (graph_t *graph, const char *filename);
+bool_t load_graph_db (graph_t *graph, const char *filename);
+
+/* Recursion analysis, defined in cycles.c. */
+long int find_cycles (graph_t *graph);
 
 /* Printing functions, defined in printgraph.c. */
-void print_graph (graph_t *graph);
-void print_graphviz_graph (graph_t *graph);
+void print_graph (graph_t *graph, int fd);
+void print_graphviz_graph (graph_t *graph, int fd);
+void print_cycles (graph_t *graph, int fd);
+void print_graphviz_cycles (graph_t *graph, int fd);
+
+/* Query server, defined in server.c. */
+bool_t serve_graph (graph_t *graph, const char *path, lex_func_t lex,
+                    void *data, const logcache_t *cache);
+
+/* File watching, defined in watch.c. */
+bool_t watch_graph (graph_t *graph, char **files, int count, int jobs,
+                    lex_func_t lex, void *data, const logcache_t *cache,
+                    print_func_t print, const char *output);
 
 #endif /* GRAPH_H */
@@ -0,0 +1,547 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+#include "graph.h"
+
+/* Magic bytes of a graph database. */
+#define GRAPHDB_MAGIC "CFLOWGDB"
+#define GRAPHDB_MAGIC_LEN 8
+
+/* Format version of the graph databases. Increase it, whenever the
+ * layout changes.
+ */
+#define GRAPHDB_VERSION 2
+
+/* Offset of a missing string. */
+#define GRAPHDB_NO_STRING 0xffffffffU
+
+/* Alignment of the strings within the string table. */
+#define GRAPHDB_ALIGN 4
+
+/* A graph database consists of the header, followed by the node table,
+ * the frozen form of the graph (the call offsets, call ids, caller
+ * offsets, caller ids and name lengths, see g_csr_t) and the string
+ * table. The strings are stored as istr_t, so that they can be used
+ * directly from the mapped file. All values are stored in the native
+ * byte order and are aligned to four bytes.
+ */
+typedef struct _graphdbheader
+{
+    char         magic[GRAPHDB_MAGIC_LEN];
+    unsigned int version;
+    unsigned int excludes; /* Excluded keyword classes (NO_*_KWDS). */
+    unsigned int complete; /* Indicates, whether all calls were kept (-c). */
+    unsigned int count;    /* Amount of nodes. */
+    unsigned int calls;    /* Amount of calls. */
+    unsigned int callers;  /* Amount of callers. */
+    unsigned int strsize;  /* Size of the string table. */
+} graphdbheader_t;
+
+/* A node of the graph database. The strings are offsets into the string
+ * table. */
+typedef struct _graphdbnode
+{
+    unsigned int name;
+    unsigned int type;
+    unsigned int file;
+    int          line;
+    unsigned int ntype;
+    unsigned int private;
+} graphdbnode_t;
+
+/* Pointers to the sections of a graph database. */
+typedef struct _graphdb
+{
+    graphdbheader_t *header;
+    graphdbnode_t   *nodes;
+    g_id_t          *calloffs;
+    g_id_t          *callids;
+    g_id_t          *calleroffs;
+    g_id_t          *callerids;
+    int             *sublen;
+    char            *strings;
+} graphdb_t;
+
+static size_t get_db_size (graphdbheader_t *header);
+static void set_sections (graphdb_t *db, char *data);
+static bool_t intern_loaded_strings (graph_t *graph);
+static unsigned int* create_string_table (strtab_t *tab, char **data,
+                                          size_t *size);
+static unsigned int get_string_offset (strtab_t *tab, unsigned int *offsets,
+                                       const char *str);
+static bool_t check_edges (g_id_t *offs, g_id_t *ids, g_id_t count,
+                           g_id_t total);
+static char* get_string (graphdb_t *db, unsigned int offset);
+
+/**
+ * Gets the size of a graph database.
+ *
+ * \param header The header of the database.
+ * \return The size of the database.
+ */
+static size_t
+get_db_size (graphdbheader_t *header)
+{
+    size_t count = header->count;
+
+    return sizeof (graphdbheader_t) + count * sizeof (graphdbnode_t) +
+        ((count + 1) * 2 + header->calls + header->callers) *
+        sizeof (g_id_t) + count * sizeof (int) + header->strsize;
+}
+
+/**
+ * Sets the pointers to the sections of a graph database.
+ *
+ * \param db The graphdb_t to set the pointers for.
+ * \param data The contents of the database, which start with a valid
+ *        header.
+ */
+static void
+set_sections (graphdb_t *db, char *data)
+{
+    size_t count;
+
+    db->header = (graphdbheader_t*) data;
+    count = db->header->count;
+    db->nodes = (graphdbnode_t*) (data + sizeof (graphdbheader_t));
+    db->calloffs = (g_id_t*) (db->nodes + count);
+    db->callids = db->calloffs + count + 1;
+    db->calleroffs = db->callids + db->header->calls;
+    db->callerids = db->calleroffs + count + 1;
+    db->sublen = (int*) (db->callerids + db->header->callers);
+    db->strings = (char*) (db->sublen + count);
+}
+
+/**
+ * Interns the names, types and files of a graph, which was loaded from a
+ * graph database. Those point into the mapped database and are not part
+ * of the string table of the graph, which is used to write it again.
+ *
+ * \param graph The graph_t to intern the strings for.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+static bool_t
+intern_loaded_strings (graph_t *graph)
+{
+    g_node_t *cur;
+
+    for (cur = graph->defines; cur; cur = cur->next)
+    {
+        cur->name = strtab_import (&graph->strings, cur->name);
+        if (!cur->name)
+            return FALSE;
+        if (cur->type)
+        {
+            cur->type = strtab_import (&graph->strings, cur->type);
+            if (!cur->type)
+                return FALSE;
+        }
+        if (cur->file)
+        {
+            cur->file = strtab_import (&graph->strings, cur->file);
+            if (!cur->file)
+                return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Creates the string table of a graph database, which contains all
+ * strings of a string table as istr_t.
+ *
+ * \param tab The strtab_t to create the string table for.
+ * \param data Receives the string table.
+ * \param size Receives the size of the string table.
+ * \return The offsets of the strings by their slot, which have to be
+ *         freed by the caller, or NULL in case of an error.
+ */
+static unsigned int*
+create_string_table (strtab_t *tab, char **data, size_t *size)
+{
+    unsigned int *offsets = malloc (tab->size * sizeof (unsigned int) + 1);
+    size_t len = 0;
+    size_t i;
+
+    *data = NULL;
+    if (!offsets)
+        return NULL;
+    for (i = 0; i < tab->size; i++)
+    {
+        if (tab->slots[i])
+            len += (offsetof (istr_t, str) + tab->slots[i]->len + 1 +
+                GRAPHDB_ALIGN - 1) & ~(size_t) (GRAPHDB_ALIGN - 1);
+    }
+    if (len >= UINT_MAX)
+    {
+        free (offsets);
+        return NULL;
+    }
+    *data = calloc (len + 1, 1);
+    if (!*data)
+    {
+        free (offsets);
+        return NULL;
+    }
+
+    *size = 0;
+    for (i = 0; i < tab->size; i++)
+    {
+        istr_t *istr = tab->slots[i];
+        if (!istr)
+            continue;
+        memcpy (*data + *size, istr, offsetof (istr_t, str) + istr->len);
+        offsets[i] = (unsigned int) (*size + offsetof (istr_t, str));
+        *size += (offsetof (istr_t, str) + istr->len + 1 +
+            GRAPHDB_ALIGN - 1) & ~(size_t) (GRAPHDB_ALIGN - 1);
+    }
+    return offsets;
+}
+
+/**
+ * Gets the offset of a string within the string table of a graph
+ * database.
+ *
+ * \param tab The strtab_t, which interned the string.
+ * \param offsets The offsets of the strings by their slot.
+ * \param str The string or NULL.
+ * \return The offset of the string or GRAPHDB_NO_STRING for NULL.
+ */
+static unsigned int
+get_string_offset (strtab_t *tab, unsigned int *offsets, const char *str)
+{
+    if (!str)
+        return GRAPHDB_NO_STRING;
+    return offsets[strtab_slot (tab, str)];
+}
+
+/**
+ * Saves a graph as graph database, which can be loaded using
+ * load_graph_db() instead of lexing the files again. The database is
+ * written under a temporary name first and renamed afterwards, so that
+ * an existing database, which the graph may have been loaded from, is
+ * kept on errors.
+ *
+ * \param graph The graph_t to save.
+ * \param filename The name of the database file to write.
+ * \return TRUE on success, FALSE on error.
+ */
+bool_t
+save_graph_db (graph_t *graph, const char *filename)
+{
+    graphdbheader_t header;
+    graphdbnode_t node;
+    g_csr_t *csr = &graph->csr;
+    g_node_t *cur;
+    unsigned int *offsets;
+    char *strings;
+    size_t strsize;
+    bool_t written;
+    g_id_t i;
+    char *tmppath;
+    size_t len;
+    FILE *fp;
+
+    if (!freeze_graph (graph))
+        return FALSE;
+    if (csr->mapped && !graph->strings.used &&
+        !intern_loaded_strings (graph))
+    {
+        fprintf (stderr, "Memory allocation error\n");
+        return FALSE;
+    }
+    offsets = create_string_table (&graph->strings, &strings, &strsize);
+    if (!offsets)
+    {
+        fprintf (stderr, "Memory allocation error\n");
+        return FALSE;
+    }
+
+    memset (&header, 0, sizeof (graphdbheader_t));
+    memcpy (header.magic, GRAPHDB_MAGIC, GRAPHDB_MAGIC_LEN);
+    header.version = GRAPHDB_VERSION;
+    header.excludes = (unsigned int) graph->excludes;
+    header.complete = (graph->complete) ? 1 : 0;
+    header.count = csr->count;
+    header.calls = csr->calloffs[csr->count];
+    header.callers = csr->calleroffs[csr->count];
+    header.strsize = (unsigned int) strsize;
+
+    len = strlen (filename) + 32;
+    tmppath = malloc (len);
+    if (!tmppath)
+    {
+        fprintf (stderr, "Memory allocation error\n");
+        free (offsets);
+        free (strings);
+        return FALSE;
+    }
+    snprintf (tmppath, len, "%s.%ld.tmp", filename, (long) getpid ());
+    fp = fopen (tmppath, "wb");
+    if (!fp)
+    {
+        perror (filename);
+        free (tmppath);
+        free (offsets);
+        free (strings);
+        return FALSE;
+    }
+
+    written = fwrite (&header, sizeof (graphdbheader_t), 1, fp) == 1;
+    for (i = 0; i < csr->count && written; i++)
+    {
+        cur = csr->nodes[i];
+        node.name = get_string_offset (&graph->strings, offsets, cur->name);
+        node.type = get_string_offset (&graph->strings, offsets, cur->type);
+        node.file = get_string_offset (&graph->strings, offsets, cur->file);
+        node.line = cur->line;
+        node.ntype = (unsigned int) cur->ntype;
+        node.private = (unsigned int) cur->private;
+        written = fwrite (&node, sizeof (graphdbnode_t), 1, fp) == 1;
+    }
+    written = written &&
+        fwrite (csr->calloffs, sizeof (g_id_t), csr->count + 1, fp) ==
+            csr->count + 1 &&
+        fwrite (csr->callids, sizeof (g_id_t), header.calls, fp) ==
+            header.calls &&
+        fwrite (csr->calleroffs, sizeof (g_id_t), csr->count + 1, fp) ==
+            csr->count + 1 &&
+        fwrite (csr->callerids, sizeof (g_id_t), header.callers, fp) ==
+            header.callers &&
+        fwrite (csr->sublen, sizeof (int), csr->count, fp) == csr->count &&
+        fwrite (strings, 1, strsize, fp) == strsize;
+    if (fclose (fp) != 0)
+        written = FALSE;
+    free (offsets);
+    free (strings);
+
+#ifdef _MSC_VER
+    /* rename() does not replace existing files on Windows. */
+    if (written)
+        remove (filename);
+#endif
+    if (!written || rename (tmppath, filename) != 0)
+    {
+        perror (filename);
+        remove (tmppath);
+        free (tmppath);
+        return FALSE;
+    }
+    free (tmppath);
+    return TRUE;
+}
+
+/**
+ * Checks the offsets and ids of the calls or callers of a graph
+ * database.
+ *
+ * \param offs The offsets of the calls or callers of each node.
+ * \param ids The called or calling nodes.
+ * \param count The amount of nodes.
+ * \param total The amount of calls or callers.
+ * \return TRUE, if the offsets and ids are valid, FALSE otherwise.
+ */
+static bool_t
+check_edges (g_id_t *offs, g_id_t *ids, g_id_t count, g_id_t total)
+{
+    g_id_t i;
+
+    if (offs[0] != 0 || offs[count] != total)
+        return FALSE;
+    for (i = 0; i < count; i++)
+    {
+        if (offs[i] > offs[i + 1])
+            return FALSE;
+    }
+    for (i = 0; i < total; i++)
+    {
+        if (ids[i] >= count)
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Gets a string of a graph database.
+ *
+ * \param db The graphdb_t to get the string from.
+ * \param offset The offset of the string.
+ * \return The string or NULL, if the offset is invalid.
+ */
+static char*
+get_string (graphdb_t *db, unsigned int offset)
+{
+    istr_t *istr;
+
+    if (offset < offsetof (istr_t, str) || offset >= db->header->strsize ||
+        (offset - offsetof (istr_t, str)) % GRAPHDB_ALIGN != 0)
+        return NULL;
+    istr = ISTR (db->strings + offset);
+    if (istr->len < 0 || istr->len >= (int) (db->header->strsize - offset) ||
+        istr->str[istr->len] != '\0')
+        return NULL;
+    return istr->str;
+}
+
+/**
+ * Loads a graph database, which was written by save_graph_db(), into an
+ * empty graph. The database is mapped into memory and its strings and
+ * the frozen form of the graph are used in place, only the nodes are
+ * created. The loaded graph can be printed and analysed, but must not
+ * be modified. Since the database either keeps the duplicate calls or
+ * not, the graph must use the same complete setting (-c) as the graph,
+ * the database was written from.
+ *
+ * \param graph The empty graph_t to load the database into.
+ * \param filename The name of the database file to load.
+ * \return TRUE on success, FALSE on error.
+ */
+bool_t
+load_graph_db (graph_t *graph, const char *filename)
+{
+    graphdb_t db;
+    graphdbheader_t header;
+    graphdbnode_t *dbnode;
+    g_csr_t *csr = &graph->csr;
+    g_node_t *nodes;
+    g_node_t *cur;
+    g_id_t i;
+
+    if (!source_open (&graph->db, filename))
+    {
+        perror (filename);
+        return FALSE;
+    }
+    if (graph->db.len < sizeof (graphdbheader_t))
+        goto invalid;
+    memcpy (&header, graph->db.data, sizeof (graphdbheader_t));
+    if (memcmp (header.magic, GRAPHDB_MAGIC, GRAPHDB_MAGIC_LEN) != 0 ||
+        header.version != GRAPHDB_VERSION || header.count >= UINT_MAX ||
+        header.count > graph->db.len / sizeof (graphdbnode_t) ||
+        header.calls > graph->db.len / sizeof (g_id_t) ||
+        header.callers > graph->db.len / sizeof (g_id_t) ||
+        header.strsize > graph->db.len ||
+        get_db_size (&header) != graph->db.len || header.complete > 1)
+        goto invalid;
+    if ((header.complete != 0) != (graph->complete != 0))
+    {
+        /* The duplicate calls cannot be added or removed afterwards. */
+        fprintf (stderr, "%s: The graph database was written %s -c\n",
+            filename, (header.complete) ? "with" : "without");
+        return FALSE;
+    }
+    set_sections (&db, graph->db.data);
+    if (!check_edges (db.calloffs, db.callids, header.count, header.calls) ||
+        !check_edges (db.calleroffs, db.callerids, header.count,
+            header.callers))
+        goto invalid;
+
+    nodes = arena_alloc (&graph->arena,
+        (size_t) header.count * sizeof (g_node_t) + 1);
+    csr->nodes = malloc ((size_t) header.count * sizeof (g_node_t*) + 1);
+    if (!nodes || !csr->nodes)
+    {
+        fprintf (stderr, "Memory allocation error\n");
+        return FALSE;
+    }
+
+    for (i = 0; i < header.count; i++)
+    {
+        dbnode = &db.nodes[i];
+        cur = &nodes[i];
+        cur->name = get_string (&db, dbnode->name);
+        cur->type = NULL;
+        if (dbnode->type != GRAPHDB_NO_STRING)
+        {
+            cur->type = get_string (&db, dbnode->type);
+            if (!cur->type)
+                goto invalid;
+        }
+        cur->file = NULL;
+        if (dbnode->file != GRAPHDB_NO_STRING)
+        {
+            cur->file = get_string (&db, dbnode->file);
+            if (!cur->file)
+                goto invalid;
+        }
+        if (!cur->name || dbnode->ntype > FUNCTION || dbnode->private > 1)
+            goto invalid;
+        cur->namelen = ISTR (cur->name)->len;
+        cur->id = (long int) i;
+        cur->line = dbnode->line;
+        cur->ntype = (NodeType) dbnode->ntype;
+        cur->private = (bool_t) dbnode->private;
+        cur->next = (i + 1 < header.count) ? &nodes[i + 1] : NULL;
+        cur->prev = (i > 0) ? &nodes[i - 1] : NULL;
+        cur->samename = NULL;
+        cur->list = NULL;
+        cur->listtail = NULL;
+        cur->callers = NULL;
+        cur->callerstail = NULL;
+        cur->printed = FALSE;
+        cur->changed = FALSE;
+        cur->scc = -1;
+        csr->nodes[i] = cur;
+    }
+
+    graph->excludes |= (int) header.excludes;
+    graph->defines = (header.count) ? nodes : NULL;
+    graph->lastdefine = (header.count) ? &nodes[header.count - 1] : NULL;
+    graph->defcount = (long int) header.count;
+    csr->calloffs = db.calloffs;
+    csr->callids = db.callids;
+    csr->calleroffs = db.calleroffs;
+    csr->callerids = db.callerids;
+    csr->sublen = db.sublen;
+    csr->count = header.count;
+    csr->valid = TRUE;
+    csr->mapped = TRUE;
+    set_graph_root (graph, graph->root);
+    return TRUE;
+
+invalid:
+    fprintf (stderr, "%s: Invalid graph database\n", filename);
+    return FALSE;
+}
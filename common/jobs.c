@@ -0,0 +1,483 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _MSC_VER
+#define HAVE_PTHREAD 1
+#include <pthread.h>
+#endif
+
+#include "graph.h"
+
+/* States of a file to process. */
+enum
+{
+    JOB_PENDING,  /* The file was not lexed yet. */
+    JOB_DONE,     /* The file was lexed, its log can be replayed. */
+    JOB_FAILED,   /* The file could not be opened. */
+    JOB_REPLAYED  /* The log was replayed and released. */
+};
+
+/* A single file to process. */
+typedef struct _job
+{
+    oplog_t     log;      /* The operations for the file. */
+    int         state;    /* The JOB_* state of the file. */
+    int         error;    /* errno value for JOB_FAILED. */
+    bool_t      cached;   /* Indicates, whether the log was cached. */
+    double      lextime;  /* Seconds spent lexing the file. */
+} job_t;
+
+#ifdef HAVE_PTHREAD
+/* Files to process, which are shared by the worker threads. */
+typedef struct _jobqueue
+{
+    char          **files;  /* The files to process. */
+    job_t          *jobs;   /* The state of the files. */
+    int             count;  /* Amount of files. */
+    int             next;   /* Next file to lex. */
+    bool_t          stop;   /* Indicates, whether the workers shall stop. */
+    lex_func_t      lex;    /* The lexer function to use. */
+    void           *data;   /* Data to pass to the lexer function. */
+    const logcache_t *cache; /* The cache of the logs or NULL. */
+    bool_t          map;    /* Indicates, whether the files may be mapped. */
+    pthread_mutex_t lock;   /* Lock for next, stop and the job states. */
+    pthread_cond_t  done;   /* Signalled, whenever a job is done. */
+} jobqueue_t;
+
+static void* run_worker (void *arg);
+static bool_t create_graph_parallel (graph_t *graph, char **files,
+                                     int count, int jobs, lex_func_t lex,
+                                     void *data, const logcache_t *cache,
+                                     bool_t map, int *failed);
+#endif
+static int lex_file (job_t *job, const char *filename, lex_func_t lex,
+                     void *data, const logcache_t *cache, bool_t map);
+static bool_t replay_job (graph_t *graph, job_t *job, const char *filename,
+                          int *failed);
+static bool_t add_files (graph_t *graph, char **files, int count, int jobs,
+                         lex_func_t lex, void *data,
+                         const logcache_t *cache, bool_t map, int *failed);
+
+/**
+ * Lexes a single file into the log of the job. If a cache is used, the
+ * log is loaded from the cache instead, if the file did not change, and
+ * stored in the cache otherwise.
+ *
+ * \param job The job_t to lex the file for.
+ * \param filename The name of the file to lex.
+ * \param lex The lexer function to use.
+ * \param data The data to pass to the lexer function.
+ * \param cache The cache of the logs or NULL.
+ * \param map Indicates, whether the file may be mapped, see source_read().
+ * \return The new state of the job, JOB_DONE or JOB_FAILED.
+ */
+static int
+lex_file (job_t *job, const char *filename, lex_func_t lex, void *data,
+          const logcache_t *cache, bool_t map)
+{
+    source_t src;
+    unsigned long long hash = 0;
+    double start = stats_time ();
+    bool_t opened;
+
+    job->cached = FALSE;
+    opened = (map) ? source_open (&src, filename) :
+        source_read (&src, filename);
+    if (!opened)
+    {
+        job->error = errno;
+        return JOB_FAILED;
+    }
+    if (cache)
+        hash = cache_hash (&src);
+    if (!oplog_init (&job->log, filename))
+        oplog_error (&job->log, "Memory allocation error");
+    else if (cache && cache_load (cache, &src, hash, &job->log))
+        job->cached = TRUE;
+    else
+    {
+        lex (&job->log, &src, data);
+        if (cache && job->log.error[0] == '\0')
+            cache_store (cache, &src, hash, &job->log);
+    }
+    source_close (&src);
+    job->lextime = stats_time () - start;
+    return JOB_DONE;
+}
+
+/**
+ * Replays the log of a lexed file into the graph and frees it. If the
+ * graph has statistics, the statistics of the file are added to them.
+ *
+ * \param graph The graph to replay the log into.
+ * \param job The job_t of the file.
+ * \param filename The name of the file.
+ * \param failed Counts the files, which could not be read or lexed and
+ *        are left out, or NULL to treat them as errors.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+replay_job (graph_t *graph, job_t *job, const char *filename, int *failed)
+{
+    stats_t *stats = graph->stats;
+    filestats_t before;
+    filestats_t file;
+    long int defcount = graph->defcount;
+    double start = 0;
+    bool_t retval;
+
+    if (job->state == JOB_FAILED)
+    {
+        errno = job->error;
+        perror (filename);
+        if (!failed)
+            return FALSE;
+        (*failed)++;
+        return TRUE;
+    }
+    if (stats)
+    {
+        before = stats->total;
+        start = stats_time ();
+    }
+    retval = oplog_replay (graph, &job->log);
+    if (!retval && failed && job->log.error[0] != '\0')
+    {
+        /* The lexer failed and the file did not add anything. */
+        (*failed)++;
+        oplog_free (&job->log);
+        job->state = JOB_REPLAYED;
+        return TRUE;
+    }
+    if (stats && retval)
+    {
+        file.file = filename;
+        file.cached = job->cached;
+        file.lextime = job->lextime;
+        file.buildtime = stats_time () - start;
+        file.lookuptime = stats->total.lookuptime - before.lookuptime;
+        file.tokens = job->log.tokens;
+        file.identifiers = job->log.identifiers;
+        file.definitions = stats->total.definitions - before.definitions;
+        file.nodes = (size_t) (graph->defcount - defcount);
+        file.edges = stats->total.edges - before.edges;
+        file.duplicates = stats->total.duplicates - before.duplicates;
+        file.lookups = stats->total.lookups - before.lookups;
+        retval = stats_add_file (stats, &file);
+    }
+    oplog_free (&job->log);
+    job->state = JOB_REPLAYED;
+    return retval;
+}
+
+#ifdef HAVE_PTHREAD
+/**
+ * Worker thread, which lexes the files of the queue until all files are
+ * processed or the queue is stopped.
+ *
+ * \param arg The jobqueue_t to process.
+ * \return Always NULL.
+ */
+static void*
+run_worker (void *arg)
+{
+    jobqueue_t *queue = arg;
+    int i;
+    int state;
+
+    while (TRUE)
+    {
+        pthread_mutex_lock (&queue->lock);
+        i = queue->next;
+        if (queue->stop || i >= queue->count)
+        {
+            pthread_mutex_unlock (&queue->lock);
+            break;
+        }
+        queue->next++;
+        pthread_mutex_unlock (&queue->lock);
+
+        state = lex_file (&queue->jobs[i], queue->files[i], queue->lex,
+            queue->data, queue->cache, queue->map);
+
+        pthread_mutex_lock (&queue->lock);
+        queue->jobs[i].state = state;
+        pthread_cond_broadcast (&queue->done);
+        pthread_mutex_unlock (&queue->lock);
+    }
+    return NULL;
+}
+
+/**
+ * Lexes the files on several threads and replays their logs into the
+ * graph in the order of the files, as soon as they are available.
+ *
+ * \param graph The graph to create.
+ * \param files The files to process.
+ * \param count The amount of files.
+ * \param jobs The amount of threads to use.
+ * \param lex The lexer function to use.
+ * \param data The data to pass to the lexer function.
+ * \param cache The cache of the logs or NULL.
+ * \param map Indicates, whether the files may be mapped.
+ * \param failed Counts the files, which could not be read or lexed and
+ *        are left out, or NULL to treat them as errors.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+create_graph_parallel (graph_t *graph, char **files, int count, int jobs,
+                       lex_func_t lex, void *data,
+                       const logcache_t *cache, bool_t map, int *failed)
+{
+    jobqueue_t queue;
+    pthread_t *threads;
+    bool_t retval = TRUE;
+    int started = 0;
+    int i;
+
+    queue.jobs = calloc ((size_t) count, sizeof (job_t));
+    threads = malloc ((size_t) jobs * sizeof (pthread_t));
+    if (!queue.jobs || !threads)
+    {
+        free (queue.jobs);
+        free (threads);
+        fprintf (stderr, "Memory allocation error\n");
+        return FALSE;
+    }
+    queue.files = files;
+    queue.count = count;
+    queue.next = 0;
+    queue.stop = FALSE;
+    queue.lex = lex;
+    queue.data = data;
+    queue.cache = cache;
+    queue.map = map;
+    pthread_mutex_init (&queue.lock, NULL);
+    pthread_cond_init (&queue.done, NULL);
+
+    for (i = 0; i < jobs; i++)
+    {
+        if (pthread_create (&threads[i], NULL, run_worker, &queue) != 0)
+            break;
+        started++;
+    }
+
+    for (i = 0; i < count && retval; i++)
+    {
+        job_t *job = &queue.jobs[i];
+
+        if (started)
+        {
+            pthread_mutex_lock (&queue.lock);
+            while (job->state == JOB_PENDING)
+                pthread_cond_wait (&queue.done, &queue.lock);
+            pthread_mutex_unlock (&queue.lock);
+        }
+        else
+        {
+            /* No thread could be started, lex the file directly. */
+            job->state = lex_file (job, files[i], lex, data, cache, map);
+        }
+        retval = replay_job (graph, job, files[i], failed);
+    }
+
+    /* Stop the workers on errors and release the logs, that were not
+     * replayed. */
+    pthread_mutex_lock (&queue.lock);
+    queue.stop = TRUE;
+    pthread_mutex_unlock (&queue.lock);
+    for (i = 0; i < started; i++)
+        pthread_join (threads[i], NULL);
+    for (i = 0; i < count; i++)
+    {
+        if (queue.jobs[i].state == JOB_DONE)
+            oplog_free (&queue.jobs[i].log);
+    }
+
+    pthread_cond_destroy (&queue.done);
+    pthread_mutex_destroy (&queue.lock);
+    free (threads);
+    free (queue.jobs);
+    return retval;
+}
+#endif
+
+/**
+ * Adds the passed files to the graph for create_graph() and
+ * update_graph().
+ *
+ * \param graph The graph to add the files to.
+ * \param files The files to process.
+ * \param count The amount of files.
+ * \param jobs The amount of threads to use for lexing.
+ * \param lex The lexer function to use.
+ * \param data The data to pass to the lexer function.
+ * \param cache The cache of the logs or NULL.
+ * \param map Indicates, whether the files may be mapped.
+ * \param failed Counts the files, which could not be read or lexed and
+ *        are left out, or NULL to treat them as errors.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+add_files (graph_t *graph, char **files, int count, int jobs,
+           lex_func_t lex, void *data, const logcache_t *cache, bool_t map,
+           int *failed)
+{
+    job_t job;
+    int i;
+
+#ifdef HAVE_PTHREAD
+    if (jobs > count)
+        jobs = count;
+    if (jobs > 1)
+        return create_graph_parallel (graph, files, count, jobs, lex, data,
+            cache, map, failed);
+#endif
+
+    for (i = 0; i < count; i++)
+    {
+        job.state = lex_file (&job, files[i], lex, data, cache, map);
+        if (!replay_job (graph, &job, files[i], failed))
+            return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Creates the graph from the passed files. Each file is lexed into an
+ * oplog_t, which is replayed into the graph in the order of the files.
+ * Using several jobs, the files are lexed concurrently, but the result
+ * is the same as for a single job.
+ *
+ * \param graph The graph to create.
+ * \param files The files to process.
+ * \param count The amount of files.
+ * \param jobs The amount of threads to use for lexing.
+ * \param lex The lexer function to use.
+ * \param data The data to pass to the lexer function.
+ * \param cache The cache of the logs or NULL.
+ * \return TRUE on success, FALSE on error.
+ */
+bool_t
+create_graph (graph_t *graph, char **files, int count, int jobs,
+              lex_func_t lex, void *data, const logcache_t *cache)
+{
+    return add_files (graph, files, count, jobs, lex, data, cache, TRUE,
+        NULL);
+}
+
+/**
+ * Updates the graph for changed files. The files of a graph are resolved
+ * against the definitions of the files before them, so the changed files
+ * and all files after them are processed again. Everything those files
+ * added to the graph is removed using retract_file(), before they are
+ * lexed and added again in their order like by create_graph(). Their
+ * nodes are added to the end of the graph. The files must be named like
+ * they were, when they were added to the graph. Files, which cannot be
+ * read or lexed anymore, are reported and stay removed from the graph,
+ * until they are updated again. The files are read instead of mapped,
+ * since they may still be written by other processes.
+ *
+ * \param graph The graph to update.
+ * \param files The changed files.
+ * \param count The amount of files.
+ * \param jobs The amount of threads to use for lexing.
+ * \param lex The lexer function to use.
+ * \param data The data to pass to the lexer function.
+ * \param cache The cache of the logs or NULL.
+ * \param failed Receives the amount of files, which could not be read or
+ *        lexed.
+ * \return TRUE on success, FALSE on error.
+ */
+bool_t
+update_graph (graph_t *graph, char **files, int count, int jobs,
+              lex_func_t lex, void *data, const logcache_t *cache,
+              int *failed)
+{
+    g_file_t *rec = NULL;
+    char **replay = NULL;
+    int first = INT_MAX;
+    int total;
+    bool_t retval = FALSE;
+    size_t i;
+    int k;
+
+    *failed = 0;
+    for (k = 0; k < count; k++)
+    {
+        rec = get_graph_file (graph, files[k]);
+        if (!rec)
+        {
+            fprintf (stderr, "%s: Not an input file of the graph\n",
+                files[k]);
+            return FALSE;
+        }
+        if (rec->index < first)
+            first = rec->index;
+    }
+    if (count == 0)
+        return TRUE;
+
+    /* The records are numbered by the position of their file. */
+    total = (int) graph->files.used - first;
+    replay = malloc ((size_t) total * sizeof (char*));
+    if (!replay)
+    {
+        fprintf (stderr, "Memory allocation error\n");
+        return FALSE;
+    }
+    for (i = 0; i < graph->files.size; i++)
+    {
+        rec = graph->files.slots[i];
+        if (rec && rec->index >= first)
+            replay[rec->index - first] = rec->name;
+    }
+
+    /* Undo the files in the reverse order, they were added in. */
+    for (k = total - 1; k >= 0; k--)
+    {
+        if (!retract_file (graph, replay[k]))
+            goto done;
+    }
+    retval = add_files (graph, replay, total, jobs, lex, data, cache, FALSE,
+        failed);
+
+done:
+    free (replay);
+    return retval;
+}
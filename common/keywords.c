@@ -0,0 +1,194 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <string.h>
+
+#include "graph.h"
+#include "ansi_keywords.h"
+#include "posix_keywords.h"
+#include "c99_keywords.h"
+#include "gcc_keywords.h"
+
+/* Amount of slots of the keyword table. It must be a power of two and
+ * keep the load factor of the table low, so that a lookup usually
+ * takes a single probe.
+ */
+#define KEYWORD_SLOTS 4096
+
+/* An entry of the keyword table. */
+typedef struct _keyword
+{
+    const char     *name;  /* The NUL-terminated keyword. */
+    unsigned short  len;   /* Length of the keyword. */
+    unsigned short  kwds;  /* The KWD_* classes of the keyword. */
+} keyword_t;
+
+/* The keyword table. It is filled once by keywords_init() and only read
+ * afterwards.
+ */
+static keyword_t keywords[KEYWORD_SLOTS];
+static size_t maxlen = 0;
+static bool_t initialized = FALSE;
+
+/* C keywords, which are skipped by the C lexer. */
+static const char* builtin_keywords[] =
+{
+    "auto", "break", "case", "const", "continue", "default", "do",
+    "else", "for", "goto", "if", "inline", "return", "sizeof", "switch",
+    "volatile", "while", NULL
+};
+
+static inline unsigned int hash_name (const char *name, size_t len);
+static keyword_t* lookup_keyword (const char *name, size_t len);
+static void add_keyword (const char *name, int kwds);
+static void add_keywords (const char* names[], int kwds);
+
+/**
+ * Calculates the FNV-1a hash value of a name.
+ *
+ * \param name The name to hash.
+ * \param len The length of the name.
+ * \return The hash value of the name.
+ */
+static inline unsigned int
+hash_name (const char *name, size_t len)
+{
+    unsigned int hash = 2166136261U;
+    while (len--)
+    {
+        hash ^= (unsigned char) *name++;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+/**
+ * Gets the slot of the keyword table, which holds the passed name or
+ * the empty slot, in which it would be placed.
+ *
+ * \param name The name to look up.
+ * \param len The length of the name.
+ * \return The slot for the name.
+ */
+static keyword_t*
+lookup_keyword (const char *name, size_t len)
+{
+    size_t pos = hash_name (name, len) & (KEYWORD_SLOTS - 1);
+    keyword_t *kw;
+
+    while ((kw = &keywords[pos])->name != NULL)
+    {
+        if (kw->len == len && memcmp (kw->name, name, len) == 0)
+            break;
+        pos = (pos + 1) & (KEYWORD_SLOTS - 1);
+    }
+    return kw;
+}
+
+/**
+ * Adds a keyword to the keyword table. Keywords, which are already
+ * known, receive the additional classes.
+ *
+ * \param name The NUL-terminated keyword to add.
+ * \param kwds The KWD_* classes of the keyword.
+ */
+static void
+add_keyword (const char *name, int kwds)
+{
+    size_t len = strlen (name);
+    keyword_t *kw = lookup_keyword (name, len);
+
+    if (!kw->name)
+    {
+        kw->name = name;
+        kw->len = (unsigned short) len;
+        if (len > maxlen)
+            maxlen = len;
+    }
+    kw->kwds |= kwds;
+}
+
+/**
+ * Adds a NULL-terminated list of keywords to the keyword table.
+ *
+ * \param names The keywords to add.
+ * \param kwds The KWD_* classes of the keywords.
+ */
+static void
+add_keywords (const char* names[], int kwds)
+{
+    const char **cur;
+    for (cur = names; *cur != NULL; cur++)
+        add_keyword (*cur, kwds);
+}
+
+/**
+ * Fills the keyword table. This has to be done once, before any thread
+ * uses keyword_class(). init_graph() takes care of that.
+ */
+void
+keywords_init (void)
+{
+    if (initialized)
+        return;
+
+    add_keywords (ansi_keywords, KWD_ANSI);
+    add_keywords (posix_keywords, KWD_POSIX);
+    add_keywords (c99_keywords, KWD_C99);
+    add_keywords (gcc_keywords, KWD_GCC);
+    add_keywords (builtin_keywords, KWD_BUILTIN);
+    add_keyword ("static", KWD_STATIC);
+    add_keyword ("typedef", KWD_TYPEDEF);
+    add_keyword ("extern", KWD_EXTERN);
+    add_keyword ("struct", KWD_STRUCT);
+    add_keyword ("union", KWD_STRUCT);
+    add_keyword ("enum", KWD_ENUM);
+    initialized = TRUE;
+}
+
+/**
+ * Classifies a name using the keyword table.
+ *
+ * \param name The name to classify, which does not need to be
+ *        NUL-terminated.
+ * \param len The length of the name.
+ * \return A bitwise combination of the KWD_* classes of the name or 0,
+ *         if the name is no keyword.
+ */
+int
+keyword_class (const char *name, size_t len)
+{
+    if (len > maxlen)
+        return 0;
+    return lookup_keyword (name, len)->kwds;
+}
@@ -0,0 +1,263 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "graph.h"
+
+/* Initial amount of operations of a log. */
+#define OPLOG_INITIAL_SIZE 256
+
+static bool_t push_call (graph_t *graph, g_subnode_t **calls,
+                         g_node_t *node);
+
+/**
+ * Initializes an empty operation log for a file.
+ *
+ * \param log The oplog_t to initialize.
+ * \param filename The name of the file the operations belong to.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+bool_t
+oplog_init (oplog_t *log, const char *filename)
+{
+    log->ops = NULL;
+    log->count = 0;
+    log->size = 0;
+    log->tokens = 0;
+    log->identifiers = 0;
+    log->error[0] = '\0';
+    arena_init (&log->arena);
+    strtab_init (&log->strings, &log->arena);
+    log->filename = strtab_intern (&log->strings, filename);
+    if (!log->filename)
+    {
+        /* Keep the name for the error message of the replay. */
+        log->filename = (char*) filename;
+        return FALSE;
+    }
+    return TRUE;
+}
+
+/**
+ * Records an operation in the log.
+ *
+ * \param log The oplog_t to record the operation in.
+ * \param op The kind of operation.
+ * \param ntype The type of the node to define.
+ * \param name The name of the node, interned by the log's string table.
+ * \param type The type of the node, interned by the log's string table,
+ *        or NULL.
+ * \param line The line of the node or -1.
+ * \param private The scope of the node or -1 to keep it.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+bool_t
+oplog_add (oplog_t *log, OpType op, NodeType ntype, char *name, char *type,
+           int line, int private)
+{
+    op_t *add;
+
+    if (log->count == log->size)
+    {
+        size_t size = (log->size) ? log->size * 2 : OPLOG_INITIAL_SIZE;
+        op_t *ops = realloc (log->ops, size * sizeof (op_t));
+        if (!ops)
+            return FALSE;
+        log->ops = ops;
+        log->size = size;
+    }
+
+    add = &log->ops[log->count++];
+    add->op = op;
+    add->ntype = ntype;
+    add->name = name;
+    add->type = type;
+    add->line = line;
+    add->private = private;
+    return TRUE;
+}
+
+/**
+ * Sets the error message of the log. The message is printed, once the
+ * log is replayed, so that errors are reported in the order of the
+ * files.
+ *
+ * \param log The oplog_t to set the error for.
+ * \param fmt The printf() style format of the message.
+ */
+void
+oplog_error (oplog_t *log, const char *fmt, ...)
+{
+    va_list args;
+
+    va_start (args, fmt);
+    vsnprintf (log->error, sizeof (log->error), fmt, args);
+    va_end (args);
+}
+
+/**
+ * Pushes a call or reference to a node on the pending calls of the
+ * current function.
+ *
+ * \param graph The graph to create the subnode in.
+ * \param calls The pending calls.
+ * \param node The called or referenced node.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+static bool_t
+push_call (graph_t *graph, g_subnode_t **calls, g_node_t *node)
+{
+    g_subnode_t *sub = create_sub_node (graph, node);
+    if (!sub)
+        return FALSE;
+    sub->next = *calls;
+    *calls = sub;
+    return TRUE;
+}
+
+/**
+ * Applies the operations of a log to the graph.
+ *
+ * \param graph The graph to apply the operations to.
+ * \param log The oplog_t to replay.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+bool_t
+oplog_replay (graph_t *graph, oplog_t *log)
+{
+    g_subnode_t *calls = NULL;
+    char *filename;
+    char *name;
+    char *type;
+    g_node_t *node;
+    op_t *op;
+    op_t *end = log->ops + log->count;
+
+    /* Keep a record for the file, even if it failed, so that it can be
+     * updated later on. */
+    filename = strtab_import (&graph->strings, log->filename);
+    if (!filename)
+        goto memerror;
+    graph->curfile = add_graph_file (graph, filename);
+    if (!graph->curfile)
+        goto memerror;
+
+    if (log->error[0] != '\0')
+    {
+        fprintf (stderr, "%s: %s\n", log->filename, log->error);
+        graph->curfile = NULL;
+        return FALSE;
+    }
+
+    for (op = log->ops; op != end; op++)
+    {
+        name = strtab_import (&graph->strings, op->name);
+        if (!name)
+            goto memerror;
+        type = NULL;
+        if (op->type)
+        {
+            type = strtab_import (&graph->strings, op->type);
+            if (!type)
+                goto memerror;
+        }
+
+        switch (op->op)
+        {
+        case OP_DEFINE:
+            node = add_g_node (graph, op->ntype, name, type, filename,
+                               op->line);
+            if (!node)
+                goto memerror;
+            if (op->private != -1)
+                node->private = op->private;
+            if (graph->stats)
+                graph->stats->total.definitions++;
+            break;
+        case OP_CALL:
+            node = get_definition_node (graph, name, filename);
+            if (!node)
+            {
+                node = add_g_node (graph, FUNCTION, name, type, filename, -1);
+                if (!node)
+                    goto memerror;
+                if (op->private != -1)
+                    node->private = op->private;
+                node->ntype = FUNCTION;
+            }
+            if (!push_call (graph, &calls, node))
+                goto memerror;
+            break;
+        case OP_REFERENCE:
+            node = get_definition_node (graph, name, filename);
+            if (node && node->ntype == VARIABLE &&
+                !push_call (graph, &calls, node))
+                goto memerror;
+            break;
+        case OP_FLUSH:
+            if (calls && !add_to_call_stack (graph, name, filename, calls))
+            {
+                graph->curfile = NULL;
+                return FALSE;
+            }
+            calls = NULL;
+            break;
+        }
+    }
+    graph->curfile = NULL;
+    return TRUE;
+
+memerror:
+    fprintf (stderr, "%s: Memory allocation error\n", log->filename);
+    graph->curfile = NULL;
+    return FALSE;
+}
+
+/**
+ * Frees the contents of an operation log, but not the oplog_t itself.
+ *
+ * \param log The oplog_t to free.
+ */
+void
+oplog_free (oplog_t *log)
+{
+    free (log->ops);
+    log->ops = NULL;
+    log->count = 0;
+    log->size = 0;
+    strtab_free (&log->strings);
+    arena_free (&log->arena);
+}
@@ -0,0 +1,249 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _MSC_VER
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "graph.h"
+
+/* Size of the output buffer. */
+#define OUTPUT_BUFFER_SIZE (256 * 1024)
+
+static bool_t write_all (output_t *out, const char *data, size_t len);
+static void output_pad (output_t *out, int count);
+
+/**
+ * Writes data completely to the file descriptor of the output.
+ *
+ * \param out The output_t to write to.
+ * \param data The data to write.
+ * \param len The length of the data.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+write_all (output_t *out, const char *data, size_t len)
+{
+    while (len > 0 && !out->error)
+    {
+#ifdef _MSC_VER
+        int count = write (out->fd, data, (unsigned int) len);
+#else
+        ssize_t count = write (out->fd, data, len);
+#endif
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            out->error = TRUE;
+            break;
+        }
+        data += count;
+        len -= (size_t) count;
+    }
+    return !out->error;
+}
+
+/**
+ * Initializes the output for a file descriptor. Pending data of the
+ * stdio streams is flushed before, so that the order of the output is
+ * kept.
+ *
+ * \param out The output_t to initialize.
+ * \param fd The file descriptor to write to.
+ * \return TRUE on success, FALSE on error.
+ */
+bool_t
+output_init (output_t *out, int fd)
+{
+    fflush (NULL);
+    out->fd = fd;
+    out->len = 0;
+    out->error = FALSE;
+    out->buf = malloc (OUTPUT_BUFFER_SIZE);
+    if (!out->buf)
+        return FALSE;
+    out->size = OUTPUT_BUFFER_SIZE;
+    return TRUE;
+}
+
+/**
+ * Writes the buffered data of the output.
+ *
+ * \param out The output_t to flush.
+ * \return TRUE on success, FALSE on error.
+ */
+bool_t
+output_flush (output_t *out)
+{
+    bool_t retval = write_all (out, out->buf, out->len);
+    out->len = 0;
+    return retval;
+}
+
+/**
+ * Flushes the output and releases its buffer.
+ *
+ * \param out The output_t to close.
+ * \return TRUE on success, FALSE, if any data could not be written.
+ */
+bool_t
+output_close (output_t *out)
+{
+    bool_t retval = output_flush (out);
+    free (out->buf);
+    out->buf = NULL;
+    out->size = 0;
+    return retval;
+}
+
+/**
+ * Appends data to the output.
+ *
+ * \param out The output_t to write to.
+ * \param data The data to write.
+ * \param len The length of the data.
+ */
+void
+output_write (output_t *out, const char *data, size_t len)
+{
+    if (out->size - out->len < len)
+    {
+        output_flush (out);
+        /* Large chunks are written directly. */
+        if (len >= out->size)
+        {
+            write_all (out, data, len);
+            return;
+        }
+    }
+    memcpy (out->buf + out->len, data, len);
+    out->len += len;
+}
+
+/**
+ * Appends a NUL-terminated string to the output.
+ *
+ * \param out The output_t to write to.
+ * \param str The string to write.
+ */
+void
+output_puts (output_t *out, const char *str)
+{
+    output_write (out, str, strlen (str));
+}
+
+/**
+ * Appends a single character to the output.
+ *
+ * \param out The output_t to write to.
+ * \param ch The character to write.
+ */
+void
+output_putc (output_t *out, int ch)
+{
+    if (out->len == out->size)
+        output_flush (out);
+    out->buf[out->len++] = (char) ch;
+}
+
+/**
+ * Appends spaces to the output.
+ *
+ * \param out The output_t to write to.
+ * \param count The amount of spaces to write.
+ */
+static void
+output_pad (output_t *out, int count)
+{
+    static const char spaces[] = "                                ";
+    size_t chunk;
+
+    while (count > 0)
+    {
+        chunk = (size_t) count;
+        if (chunk > sizeof (spaces) - 1)
+            chunk = sizeof (spaces) - 1;
+        output_write (out, spaces, chunk);
+        count -= (int) chunk;
+    }
+}
+
+/**
+ * Appends a string, which is right-aligned to a certain width, to the
+ * output. This is the same as printf()'s "%*s".
+ *
+ * \param out The output_t to write to.
+ * \param str The string to write.
+ * \param len The length of the string.
+ * \param width The minimum width of the field.
+ */
+void
+output_str (output_t *out, const char *str, size_t len, int width)
+{
+    if (width > 0 && (size_t) width > len)
+        output_pad (out, width - (int) len);
+    output_write (out, str, len);
+}
+
+/**
+ * Appends an integer, which is right-aligned to a certain width, to the
+ * output. This is the same as printf()'s "%*ld".
+ *
+ * \param out The output_t to write to.
+ * \param val The value to write.
+ * \param width The minimum width of the field.
+ */
+void
+output_int (output_t *out, long val, int width)
+{
+    char digits[24];
+    char *p = digits + sizeof (digits);
+    unsigned long uval = (val < 0) ? 0UL - (unsigned long) val :
+        (unsigned long) val;
+
+    do
+    {
+        *--p = (char) ('0' + uval % 10);
+        uval /= 10;
+    }
+    while (uval > 0);
+    if (val < 0)
+        *--p = '-';
+    output_str (out, p, (size_t) (digits + sizeof (digits) - p), width);
+}
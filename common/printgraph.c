@@ -40,16 +40,56 @@ __FBSDID("$FreeBSD$");
   */     
 #define INDENT 3
 
+/* Initial amount of frames of the preorder walkthroughs. */
+#define FRAMESTACK_INITIAL_SIZE 64
+
+/* Calls of a node, which still have to be visited by a preorder
+ * walkthrough.
+ */
+typedef struct _frame
+{
+    g_id_t       pos;     /* Position of the next call to visit. */
+    g_id_t       end;     /* End of the calls. */
+    int          depth;   /* The depth of the calls. */
+    size_t       maxlen;  /* The name length for the indentation. */
+} frame_t;
+
+/* Explicit stack of a preorder walkthrough, which keeps the depth of a
+ * call graph independent from the size of the system stack.
+ */
+typedef struct _framestack
+{
+    frame_t     *frames;  /* The frames. */
+    size_t       count;   /* Amount of used frames. */
+    size_t       size;    /* Amount of allocated frames. */
+} framestack_t;
+
 static int compare_gnodes (const void *a, const void *b);
-static bool_t nodes_contain (node_t* list, char *name);
-static void print_node (g_node_t *node, int pad, size_t maxlen, int count);
-static void print_preorder (graph_t *graph, g_node_t *node, int depth,
-                            size_t maxlen, int pad, int *count);
-static void print_callers (graph_t *graph, g_node_t *node, int depth,
-                           size_t maxlen, int pad, int *count);
-static void print_graphviz_node (g_node_t *node);
-static void print_graphviz_preorder (graph_t *graph, g_node_t *node, int depth);
-static void print_graphviz_callers (graph_t *graph, g_node_t *node, int depth);
+static int compare_cycles (const void *a, const void *b);
+static bool_t is_excluded (graph_t *graph, char *name);
+static void print_node (output_t *out, g_node_t *node, int pad,
+                        size_t maxlen, int count);
+static bool_t push_frame (framestack_t *stack, g_csr_t *csr, g_id_t id,
+                          int depth, size_t maxlen);
+static bool_t visit_node (output_t *out, graph_t *graph, g_node_t *node,
+                          int depth, size_t maxlen, int pad, int *count);
+static bool_t print_preorder (output_t *out, graph_t *graph, g_node_t *node,
+                              size_t maxlen, int pad, int *count);
+static void print_callers (output_t *out, graph_t *graph, g_node_t *node,
+                           int depth, size_t maxlen, int pad, int *count);
+static void print_graphviz_node (output_t *out, g_node_t *node);
+static void print_graphviz_edge (output_t *out, g_node_t *node,
+                                 g_node_t *sub, long int count);
+static bool_t visit_graphviz_node (output_t *out, graph_t *graph,
+                                   g_node_t *node, int depth);
+static bool_t print_graphviz_preorder (output_t *out, graph_t *graph,
+                                       g_node_t *node);
+static void print_graphviz_callers (output_t *out, graph_t *graph,
+                                    g_node_t *node, int depth);
+static bool_t is_hidden (graph_t *graph, g_node_t *node);
+static void reset_printed (graph_t *graph);
+static g_node_t** get_cycles (graph_t *graph, long int *count);
+static g_node_t** get_sorted_nodes (graph_t *graph);
 
 /**
  * Qsort comparer that compares the names of two passed g_node_t
@@ -62,124 +102,221 @@ static void print_graphviz_callers (graph_t *graph, g_node_t *node, int depth);
 static int
 compare_gnodes (const void *a, const void *b)
 {
-    return strcmp ((*(g_node_t* const*)a)->name, (*(g_node_t* const*)b)->name);
+    char *name1 = (*(g_node_t* const*)a)->name;
+    char *name2 = (*(g_node_t* const*)b)->name;
+
+    /* Interned names are equal, if they share the same address. */
+    if (name1 == name2)
+        return 0;
+    return strcmp (name1, name2);
+}
+
+/**
+ * Qsort comparer that orders two passed g_node_t pointers by their
+ * recursion group and name.
+ *
+ * \param a The first g_node_t to compare.
+ * \param b The second g_node_t to compare.
+ * \return A strcmp() like value.
+ */
+static int
+compare_cycles (const void *a, const void *b)
+{
+    long int scc1 = (*(g_node_t* const*)a)->scc;
+    long int scc2 = (*(g_node_t* const*)b)->scc;
+
+    if (scc1 != scc2)
+        return (scc1 < scc2) ? -1 : 1;
+    return compare_gnodes (a, b);
 }
 
 /**
- * Checks whether a node with the specified name exists in the passed
- * list.
+ * Checks, whether the passed name is excluded by the graph.
  *
- * \param list The node_t list to check.
- * \param name The NUL-terminated name to check for.
- * \return TRUE, if a node with the name exists, FALSE otherwise.
+ * \param graph The graph to check for the exclusion.
+ * \param name The interned name to check.
+ * \return TRUE, if the name is excluded, FALSE otherwise.
  */
 static bool_t
-nodes_contain (node_t* list, char *name)
+is_excluded (graph_t *graph, char *name)
 {
-    while (list)
-    {
-        if (strcmp (list->name, name) == 0)
-            return TRUE;
-        list = list->next;
-    }
-    return FALSE;
+    if (!graph->excludes)
+        return FALSE;
+    return (keyword_class (name, (size_t) ISTR (name)->len) &
+        graph->excludes) != 0;
 }
 
 /**
  * Prints a g_node_t node.
  * 
+ * \param out The output_t to print to.
  * \param node The node to print.
  * \param pad The left handed padding to use.
  * \param maxlen The maximum length of all nodes on that level.
  * \param count The padding modifier.
  */
 static void
-print_node (g_node_t *node, int pad, size_t maxlen, int count)
+print_node (output_t *out, g_node_t *node, int pad, size_t maxlen, int count)
 {
+    /* Prints "%*d %*s: " followed by the node details. */
+    output_int (out, count, pad);
+    output_putc (out, ' ');
+    output_str (out, node->name, (size_t) node->namelen, (int) maxlen);
+    output_write (out, ": ", 2);
+
     if (node->line != -1)
     {
+        if (node->type)
+            output_puts (out, node->type);
         if (node->ntype == VARIABLE)
         {
-            if (!node->type)
-                printf ("%*d %*s: <%s %d>\n", pad, count, (int)maxlen,
-                        node->name, node->file, node->line);
+            /* <file line> or type, <file line> */
+            if (node->type)
+                output_write (out, ", <", 3);
             else
-                printf ("%*d %*s: %s, <%s %d>\n", pad, count, (int)maxlen,
-                        node->name, node->type, node->file, node->line);
+                output_putc (out, '<');
         }
         else
-        {
-            if (!node->type)
-                printf ("%*d %*s: (), <%s %d>\n", pad, count, (int)maxlen,
-                        node->name, node->file, node->line);
-            else
-                printf ("%*d %*s: %s(), <%s %d>\n", pad, count, (int)maxlen,
-                        node->name, node->type, node->file, node->line);
-        }
+            output_write (out, "(), <", 5);
+        output_puts (out, node->file);
+        output_putc (out, ' ');
+        output_int (out, node->line, 0);
+        output_write (out, ">\n", 2);
     }
     else
-        printf ("%*d %*s: <>\n", pad, count, (int)maxlen, node->name);
+        output_write (out, "<>\n", 3);
 }
 
 /**
- * Prints the graph nodes using a preorder walkthrough. 
+ * Pushes the calls of a node on the stack of a preorder walkthrough.
+ *
+ * \param stack The framestack_t to push the calls on.
+ * \param csr The frozen graph.
+ * \param id The id of the node, whose calls have to be visited.
+ * \param depth The depth of the calls.
+ * \param maxlen The name length for the indentation of the calls.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+static bool_t
+push_frame (framestack_t *stack, g_csr_t *csr, g_id_t id, int depth,
+            size_t maxlen)
+{
+    frame_t *frame;
+
+    if (stack->count == stack->size)
+    {
+        size_t size = (stack->size) ? stack->size * 2 :
+            FRAMESTACK_INITIAL_SIZE;
+        frame_t *frames = realloc (stack->frames, size * sizeof (frame_t));
+        if (!frames)
+            return FALSE;
+        stack->frames = frames;
+        stack->size = size;
+    }
+
+    frame = &stack->frames[stack->count++];
+    frame->pos = csr->calloffs[id];
+    frame->end = csr->calloffs[id + 1];
+    frame->depth = depth;
+    frame->maxlen = maxlen;
+    return TRUE;
+}
+
+/**
+ * Prints a node of a preorder walkthrough.
  *
+ * \param out The output_t to print to.
  * \param graph The graph_t to print.
- * \param node The g_node_t to start from.
+ * \param node The g_node_t to print.
  * \param depth The node depth related to its position.
  * \param maxlen The maximum name length for the indentation on this
  *               depth.
  * \param pad The additional padding for the line numbers to print.
  * \param count The amount of nodes printed already (= line number).
+ * \return TRUE, if the calls of the node have to be printed, FALSE
+ *         otherwise.
  */
-static void
-print_preorder (graph_t *graph, g_node_t *node, int depth, size_t maxlen,
-                int pad, int *count)
+static bool_t
+visit_node (output_t *out, graph_t *graph, g_node_t *node, int depth,
+            size_t maxlen, int pad, int *count)
 {
-    int sublen = 0;
-    g_subnode_t *sub = NULL;
-
     /* Skip functions and data starting with an underscore on demand. */
     if (!graph->privates && node->name[0] == '_')
-        return;
+        return FALSE;
     if (!graph->statics && node->ntype == VARIABLE)
-        return;
+        return FALSE;
 
     /* Skip excluded keywords. */
-    if (nodes_contain (graph->excludes, node->name))
-        return;
+    if (is_excluded (graph, node->name))
+        return FALSE;
 
-    print_node (node, pad, maxlen, *count);
+    print_node (out, node, pad, maxlen, *count);
 
     (*count)++;
     if (node->printed)
-        return;
+        return FALSE;
     node->printed = TRUE;
-    
-    if (depth >= graph->depth)
-        return;
 
-    sub = node->list;
-    while (sub)
-    {
-        if (sub->content->namelen > sublen)
-            sublen = sub->content->namelen;
-        sub = sub->next;
-    }
+    return depth < graph->depth;
+}
 
-    sub = node->list;
-    while (sub)
+/**
+ * Prints the graph nodes using a preorder walkthrough. 
+ *
+ * \param out The output_t to print to.
+ * \param graph The graph_t to print.
+ * \param node The g_node_t to start from.
+ * \param maxlen The maximum name length for the indentation of the
+ *               node.
+ * \param pad The additional padding for the line numbers to print.
+ * \param count The amount of nodes printed already (= line number).
+ * \return TRUE on success, FALSE in case of an error.
+ */
+static bool_t
+print_preorder (output_t *out, graph_t *graph, g_node_t *node,
+                size_t maxlen, int pad, int *count)
+{
+    g_csr_t *csr = &graph->csr;
+    framestack_t stack = { NULL, 0, 0 };
+    frame_t *top = NULL;
+    g_id_t id = (g_id_t) node->id;
+    bool_t retval = TRUE;
+
+    if (!visit_node (out, graph, node, 0, maxlen, pad, count) ||
+        csr->calloffs[id] == csr->calloffs[id + 1])
+        return TRUE;
+    if (!push_frame (&stack, csr, id, 1, maxlen + csr->sublen[id] + INDENT))
+        retval = FALSE;
+
+    while (retval && stack.count > 0)
     {
-        print_preorder (graph, sub->content, depth + 1,
-            maxlen + sublen + INDENT, pad, count);
-        sub = sub->next;
+        top = &stack.frames[stack.count - 1];
+        if (top->pos == top->end)
+        {
+            stack.count--;
+            continue;
+        }
+
+        id = csr->callids[top->pos++];
+        if (visit_node (out, graph, csr->nodes[id], top->depth, top->maxlen,
+                pad, count) && csr->calloffs[id] != csr->calloffs[id + 1])
+        {
+            /* Down the tree, the push may move the frames. */
+            retval = push_frame (&stack, csr, id, top->depth + 1,
+                top->maxlen + csr->sublen[id] + INDENT);
+        }
     }
-}
 
+    free (stack.frames);
+    if (!retval)
+        fprintf (stderr, "Memory allocation error\n");
+    return retval;
+}
 
 /**
  * Prints the graph nodes in a caller<->callee order.
  *
+ * \param out The output_t to print to.
  * \param graph The graph_t to print.
  * \param node The g_node_t to start from.
  * \param depth The node depth related to its position.
@@ -189,11 +326,15 @@ print_preorder (graph_t *graph, g_node_t *node, int depth, size_t maxlen,
  * \param count The amount of nodes printed already (= line number).
  */
 static void
-print_callers (graph_t *graph, g_node_t *node, int depth, size_t maxlen,
-               int pad, int *count)
+print_callers (output_t *out, graph_t *graph, g_node_t *node, int depth,
+               size_t maxlen, int pad, int *count)
 {
+    g_csr_t *csr = &graph->csr;
+    g_node_t *caller = NULL;
+    g_id_t start = csr->calleroffs[node->id];
+    g_id_t end = csr->calleroffs[node->id + 1];
+    g_id_t i;
     int sublen = 0;
-    g_subnode_t *sub = NULL;
 
     /* Skip functions and data starting with an underscore on demand. */
     if (!graph->privates && node->name[0] == '_')
@@ -202,69 +343,106 @@ print_callers (graph_t *graph, g_node_t *node, int depth, size_t maxlen,
         return;
 
     /* Skip excluded keywords. */
-    if (nodes_contain (graph->excludes, node->name))
+    if (is_excluded (graph, node->name))
         return;
 
-    print_node (node, pad, maxlen, *count);
+    print_node (out, node, pad, maxlen, *count);
 
     (*count)++;
     
     if (depth >= graph->depth)
         return;
 
-    sub = node->callers;
-    while (sub)
+    for (i = start; i < end; i++)
     {
-        if (sub->content->namelen > sublen)
-            sublen = sub->content->namelen;
-        sub = sub->next;
+        caller = csr->nodes[csr->callerids[i]];
+        if (caller->namelen > sublen)
+            sublen = caller->namelen;
     }
 
-    sub = node->callers;
-    while (sub)
+    for (i = start; i < end; i++)
     {
+        caller = csr->nodes[csr->callerids[i]];
         /* Skip functions and data starting with an underscore on demand. */
-        if (!graph->privates && sub->content->name[0] == '_')
+        if (!graph->privates && caller->name[0] == '_')
             return;
-        if (!graph->statics && sub->content->ntype == VARIABLE)
+        if (!graph->statics && caller->ntype == VARIABLE)
             return;
-        print_node (sub->content, pad, maxlen + sublen + 1, *count);
+        print_node (out, caller, pad, maxlen + sublen + 1, *count);
         (*count)++;
-        sub = sub->next;
     }
 }
 
+/**
+ * Gets the nodes of the frozen graph sorted by their names.
+ *
+ * \param graph The graph_t to get the nodes for.
+ * \return The nodes, which have to be freed by the caller, or NULL in
+ *         case of an error.
+ */
+static g_node_t**
+get_sorted_nodes (graph_t *graph)
+{
+    g_csr_t *csr = &graph->csr;
+    g_node_t **nodes = malloc (sizeof (g_node_t *) * csr->count + 1);
+
+    if (!nodes)
+    {
+        fprintf (stderr, "Memory allocation error\n");
+        return NULL;
+    }
+    memcpy (nodes, csr->nodes, sizeof (g_node_t *) * csr->count);
+    qsort (nodes, (size_t) csr->count, sizeof (g_node_t*), compare_gnodes);
+    return nodes;
+}
+
+/**
+ * Resets the printed state of the nodes of a frozen graph, so that the
+ * graph can be printed several times.
+ *
+ * \param graph The graph_t to reset.
+ */
+static void
+reset_printed (graph_t *graph)
+{
+    g_csr_t *csr = &graph->csr;
+    g_id_t i;
+
+    for (i = 0; i < csr->count; i++)
+        csr->nodes[i]->printed = FALSE;
+}
+
 /**
  * Prints a graph.
  *
  * \param graph The graph_t to print.
+ * \param fd The file descriptor to print to.
  */
 void
-print_graph (graph_t *graph)
+print_graph (graph_t *graph, int fd)
 {
+    output_t out;
+    g_csr_t *csr = &graph->csr;
     g_node_t *cur = NULL;
-    g_subnode_t *sub = NULL;
+    g_id_t i;
     int count = 0;
     size_t maxlen = 0;
     int pad = 0;
 
+    if (!freeze_graph (graph))
+        return;
+    reset_printed (graph);
+
     /* Get the maximum name length. */
-    cur = graph->defines;
-    while (cur)
+    for (i = 0; i < csr->count; i++)
     {
         /* Only use the height of the top root nodes. */
-        if (!cur->callers && (size_t) cur->namelen > maxlen)
+        cur = csr->nodes[i];
+        if (csr->calleroffs[i] == csr->calleroffs[i + 1] &&
+            (size_t) cur->namelen > maxlen)
             maxlen = cur->namelen;
-
-        sub = cur->list;
-        while (sub)
-        {
-            count++;
-            sub = sub->next;
-        }
-        count++;
-        cur = cur->next;
     }
+    count = (int) (csr->count + csr->calloffs[csr->count]);
 
     /* Add an additional padding for the line numbers. */
     while (count > 0)
@@ -273,139 +451,199 @@ print_graph (graph_t *graph)
         pad++;
     }
 
+    if (!output_init (&out, fd))
+    {
+        fprintf (stderr, "Memory allocation error\n");
+        return;
+    }
+
     count = 1;
-    cur = graph->defines;
     if (!graph->reversed)
     {
         /* Usual preorder run. */
         if (graph->rootnode)
-            print_preorder (graph, graph->rootnode, 0,
-                strlen (graph->rootnode->name), pad, &count);
+            print_preorder (&out, graph, graph->rootnode,
+                (size_t) graph->rootnode->namelen, pad, &count);
         else
         {
-            while (cur)
+            for (i = 0; i < csr->count; i++)
             {
-                if (!cur->printed)
-                    print_preorder (graph, cur, 0, maxlen, pad, &count);
-                cur = cur->next;
+                cur = csr->nodes[i];
+                if (!cur->printed &&
+                    !print_preorder (&out, graph, cur, maxlen, pad, &count))
+                    break;
             }
         }
     }
     else
     {
         /* Print a reversed callee:caller graph. */
-        int i = 0;
-        g_node_t **rev = malloc (sizeof (g_node_t *) * graph->defcount);
+        g_node_t **rev = get_sorted_nodes (graph);
         if (!rev)
         {
-            fprintf (stderr, "Memory allocation error\n");
+            output_close (&out);
             return;
         }
-        while (cur)
-        {
-            rev[i] = cur;
-            cur = cur->next;
-            i++;
-        }
-        qsort (rev, (size_t) graph->defcount, sizeof (g_node_t*),
-            compare_gnodes);
-        for (i = 0; i < graph->defcount; i++)
-            print_callers(graph, rev[i], 0, maxlen, pad, &count);
+        for (i = 0; i < csr->count; i++)
+            print_callers (&out, graph, rev[i], 0, maxlen, pad, &count);
         free (rev);
     }
+    output_close (&out);
 }
 
 /**
  * Prints a node using the graphvis conventiosn.
  *
+ * \param out The output_t to print to.
  * \param node The g_node_t to print.
  */
 static void
-print_graphviz_node (g_node_t *node)
+print_graphviz_node (output_t *out, g_node_t *node)
 {
-    (node->ntype == VARIABLE) ? printf ("%s_var", node->name) :
-        printf ("%s", node->name);
+    output_write (out, node->name, (size_t) node->namelen);
+    if (node->ntype == VARIABLE)
+        output_write (out, "_var", 4);
+}
+
+/**
+ * Prints a link between two nodes using the graphviz conventions.
+ *
+ * \param out The output_t to print to.
+ * \param node The calling g_node_t.
+ * \param sub The called g_node_t.
+ * \param count The number of the link.
+ */
+static void
+print_graphviz_edge (output_t *out, g_node_t *node, g_node_t *sub,
+                     long int count)
+{
+    output_write (out, "  ", 2);
+    print_graphviz_node (out, node);
+    output_write (out, " -> ", 4);
+    print_graphviz_node (out, sub);
+    output_write (out, " [label=\"", 9);
+    output_int (out, count, 0);
+    output_write (out, "\"];\n", 4);
 }
 
 
 /**
- * Prints the graph nodes using a preorder walkthrough using the
+ * Prints the links of a node of a preorder walkthrough using the
  * graphviz conventions.
  *
+ * \param out The output_t to print to.
  * \param graph The graph_t to print.
- * \param node The g_node_t to start from.
+ * \param node The g_node_t to print the links for.
  * \param depth The node depth related to its position.
+ * \return TRUE, if the calls of the node have to be visited, FALSE
+ *         otherwise.
  */
-static void
-print_graphviz_preorder (graph_t *graph, g_node_t *node, int depth)
+static bool_t
+visit_graphviz_node (output_t *out, graph_t *graph, g_node_t *node,
+                     int depth)
 {
-    g_subnode_t *sub = NULL;
+    g_csr_t *csr = &graph->csr;
+    g_node_t *callee = NULL;
+    g_id_t start = csr->calloffs[node->id];
+    g_id_t end = csr->calloffs[node->id + 1];
+    g_id_t i;
     long int count = 0;
 
     /* Skip functions and data starting with an underscore on demand. */
     if (!graph->privates && node->name[0] == '_')
-        return;
+        return FALSE;
     if (!graph->statics && node->ntype == VARIABLE)
-        return;
+        return FALSE;
 
     /* Skip excluded keywords. */
-    if (nodes_contain (graph->excludes, node->name))
-        return;
+    if (is_excluded (graph, node->name))
+        return FALSE;
 
     if (node->printed)
-        return;
+        return FALSE;
     node->printed = TRUE;
 
     if (depth >= graph->depth)
-        return;
+        return FALSE;
 
     /* Create the graphviz node links. */
-    sub = node->list;
-    while (sub)
+    for (i = start; i < end; i++)
     {
         /* If the subnode matches the exclude criteria, do not print it. */
-        if ((!graph->privates && sub->content->name[0] == '_') ||
-            (!graph->statics && sub->content->ntype == VARIABLE) ||
-            nodes_contain (graph->excludes, sub->content->name))
-        {
-            sub = sub->next;
+        callee = csr->nodes[csr->callids[i]];
+        if (is_hidden (graph, callee))
             continue;
-        }
 
         count++;
 
         /* Link the node. */
-        printf ("  ");
-        print_graphviz_node (node);
-        printf (" -> ");
-        print_graphviz_node (sub->content);
-        printf (" [label=\"%ld\"];\n", count);
-
-        sub = sub->next;
+        print_graphviz_edge (out, node, callee, count);
     }
+    return start != end;
+}
+
+/**
+ * Prints the graph nodes using a preorder walkthrough using the
+ * graphviz conventions.
+ *
+ * \param out The output_t to print to.
+ * \param graph The graph_t to print.
+ * \param node The g_node_t to start from.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+static bool_t
+print_graphviz_preorder (output_t *out, graph_t *graph, g_node_t *node)
+{
+    g_csr_t *csr = &graph->csr;
+    framestack_t stack = { NULL, 0, 0 };
+    frame_t *top = NULL;
+    g_id_t id = 0;
+    bool_t retval = TRUE;
+
+    if (!visit_graphviz_node (out, graph, node, 0))
+        return TRUE;
+    if (!push_frame (&stack, csr, (g_id_t) node->id, 1, 0))
+        retval = FALSE;
 
     /* Down the tree in a preorder traversal. */
-    sub = node->list;
-    while (sub)
+    while (retval && stack.count > 0)
     {
-        print_graphviz_preorder (graph, sub->content, depth + 1);
-        sub = sub->next;
+        top = &stack.frames[stack.count - 1];
+        if (top->pos == top->end)
+        {
+            stack.count--;
+            continue;
+        }
+
+        id = csr->callids[top->pos++];
+        if (visit_graphviz_node (out, graph, csr->nodes[id], top->depth))
+            retval = push_frame (&stack, csr, id, top->depth + 1, 0);
     }
 
+    free (stack.frames);
+    if (!retval)
+        fprintf (stderr, "Memory allocation error\n");
+    return retval;
 }
 
 /**
  * Prints the graph nodes in a caller<->callee order using the graphviz
  * conventions.
  *
+ * \param out The output_t to print to.
  * \param graph The graph_t to print.
  * \param node The g_node_t to start from.
  * \param depth The node depth related to its position.
  */
 static void
-print_graphviz_callers (graph_t *graph, g_node_t *node, int depth)
+print_graphviz_callers (output_t *out, graph_t *graph, g_node_t *node,
+                        int depth)
 {
-    g_subnode_t *sub = NULL;
+    g_csr_t *csr = &graph->csr;
+    g_node_t *caller = NULL;
+    g_id_t start = csr->calleroffs[node->id];
+    g_id_t end = csr->calleroffs[node->id + 1];
+    g_id_t i;
     long int count = 0;
 
     /* Skip functions and data starting with an underscore on demand. */
@@ -415,7 +653,7 @@ print_graphviz_callers (graph_t *graph, g_node_t *node, int depth)
         return;
 
     /* Skip excluded keywords. */
-    if (nodes_contain (graph->excludes, node->name))
+    if (is_excluded (graph, node->name))
         return;
 
     if (node->printed)
@@ -426,30 +664,17 @@ print_graphviz_callers (graph_t *graph, g_node_t *node, int depth)
         return;
 
     /* Create the graphviz node links. */
-    sub = node->callers;
-    depth += 1;
-    while (sub)
+    for (i = start; i < end; i++)
     {
-
         /* If the subnode matches the exclude criteria, do not print it. */
-        if ((!graph->privates && sub->content->name[0] == '_') ||
-            (!graph->statics && sub->content->ntype == VARIABLE) ||
-            nodes_contain (graph->excludes, sub->content->name))
-        {
-            sub = sub->next;
+        caller = csr->nodes[csr->callerids[i]];
+        if (is_hidden (graph, caller))
             continue;
-        }
 
         count++;
 
         /* Link the node. */
-        printf ("  ");
-        print_graphviz_node (node);
-        printf (" -> ");
-        print_graphviz_node (sub->content);
-        printf (" [label=\"%ld\"];\n", count);
-
-        sub = sub->next;
+        print_graphviz_edge (out, node, caller, count);
     }
 }
 
@@ -457,79 +682,238 @@ print_graphviz_callers (graph_t *graph, g_node_t *node, int depth)
  * Prints a graph using the graphviz conventions.
  *
  * \param graph The graph_t to print.
+ * \param fd The file descriptor to print to.
  */
 void
-print_graphviz_graph (graph_t *graph)
+print_graphviz_graph (graph_t *graph, int fd)
 {
+    output_t out;
+    g_csr_t *csr = &graph->csr;
     g_node_t *cur = NULL;
+    g_id_t i;
 
-    printf ("digraph \"%s\" {\n", "TODO");
+    if (!freeze_graph (graph))
+        return;
+    reset_printed (graph);
+    if (!output_init (&out, fd))
+    {
+        fprintf (stderr, "Memory allocation error\n");
+        return;
+    }
+
+    output_puts (&out, "digraph \"TODO\" {\n");
 
-    cur = graph->defines;
     if (!graph->reversed)
     {
         /* Usual preorder run. */
         if (graph->rootnode)
-            print_graphviz_preorder (graph, graph->rootnode, 0);
+            print_graphviz_preorder (&out, graph, graph->rootnode);
         else
         {
-            while (cur)
+            for (i = 0; i < csr->count; i++)
             {
-                if (!cur->printed)
-                    print_graphviz_preorder (graph, cur, 0);
-                cur = cur->next;
+                cur = csr->nodes[i];
+                if (!cur->printed &&
+                    !print_graphviz_preorder (&out, graph, cur))
+                    break;
             }
         }
     }
     else
     {
         /* Print a reversed callee:caller graph. */
-        int i = 0;
-        g_node_t **rev = malloc (sizeof (g_node_t *) * graph->defcount);
+        g_node_t **rev = get_sorted_nodes (graph);
         if (!rev)
         {
-            fprintf (stderr, "Memory allocation error\n");
+            output_close (&out);
             return;
         }
-        while (cur)
-        {
-            rev[i] = cur;
-            cur = cur->next;
-            i++;
-        }
-        qsort (rev, (size_t) graph->defcount, sizeof (g_node_t*),
-            compare_gnodes);
-        for (i = 0; i < graph->defcount; i++)
-            print_graphviz_callers (graph, rev[i], 0);
+        for (i = 0; i < csr->count; i++)
+            print_graphviz_callers (&out, graph, rev[i], 0);
         free (rev);
     }
 
     /* Create all node descriptions first */
-    cur = graph->defines;
-    while (cur)
+    for (i = 0; i < csr->count; i++)
     {
         /* 
          * If the subnode matches the exclude criteria, do not print it.
          * If it was not printed already, do not show it as well as it
          * is unlikely that it was referenced by another node.
          */
-        if ((!graph->privates && cur->name[0] == '_') ||
-            (!graph->statics && cur->ntype == VARIABLE) ||
-            nodes_contain (graph->excludes, cur->name) ||
-            !cur->printed)
-        {
-            cur = cur->next;
+        cur = csr->nodes[i];
+        if (is_hidden (graph, cur) || !cur->printed)
             continue;
-        }
 
+        output_write (&out, "  ", 2);
+        print_graphviz_node (&out, cur);
+        output_write (&out, " [label=\"", 9);
+        output_write (&out, cur->name, (size_t) cur->namelen);
         if (cur->ntype == VARIABLE)
-            printf ("  %s_var [label=\"%s\",shape=box];\n", cur->name,
-                cur->name);
+            output_write (&out, "\",shape=box];\n", 14);
         else
-            printf ("  %s [label=\"%s\"];\n", cur->name, cur->name);
-        cur = cur->next;
+            output_write (&out, "\"];\n", 4);
     }
 
-    printf ("}\n");
+    output_write (&out, "}\n", 2);
+    output_close (&out);
+}
+
+/**
+ * Checks, whether a node is hidden by the options of the graph.
+ *
+ * \param graph The graph_t to check the options of.
+ * \param node The g_node_t to check.
+ * \return TRUE, if the node shall not be printed, FALSE otherwise.
+ */
+static bool_t
+is_hidden (graph_t *graph, g_node_t *node)
+{
+    return (!graph->privates && node->name[0] == '_') ||
+        (!graph->statics && node->ntype == VARIABLE) ||
+        is_excluded (graph, node->name);
+}
+
+/**
+ * Gets the visible nodes of all recursion groups of the graph, ordered
+ * by their group and name.
+ *
+ * \param graph The graph_t to get the recursion groups for.
+ * \param count Receives the amount of nodes.
+ * \return The nodes, which have to be freed by the caller, or NULL in
+ *         case of an error.
+ */
+static g_node_t**
+get_cycles (graph_t *graph, long int *count)
+{
+    g_csr_t *csr = &graph->csr;
+    g_node_t **nodes = NULL;
+    g_id_t i;
+
+    *count = 0;
+    if (find_cycles (graph) == -1)
+        return NULL;
+
+    nodes = malloc (sizeof (g_node_t *) * csr->count + 1);
+    if (!nodes)
+    {
+        fprintf (stderr, "Memory allocation error\n");
+        return NULL;
+    }
+    for (i = 0; i < csr->count; i++)
+    {
+        if (csr->nodes[i]->scc != -1 && !is_hidden (graph, csr->nodes[i]))
+            nodes[(*count)++] = csr->nodes[i];
+    }
+    qsort (nodes, (size_t) *count, sizeof (g_node_t*), compare_cycles);
+    return nodes;
+}
+
+/**
+ * Prints the recursion groups of a graph. Each line contains the
+ * number of a group followed by the names of its functions.
+ *
+ * \param graph The graph_t to print.
+ * \param fd The file descriptor to print to.
+ */
+void
+print_cycles (graph_t *graph, int fd)
+{
+    output_t out;
+    long int count = 0;
+    long int i;
+    g_node_t **nodes = get_cycles (graph, &count);
+
+    if (!nodes)
+        return;
+    if (!output_init (&out, fd))
+    {
+        free (nodes);
+        fprintf (stderr, "Memory allocation error\n");
+        return;
+    }
+
+    for (i = 0; i < count; i++)
+    {
+        if (i == 0 || nodes[i]->scc != nodes[i - 1]->scc)
+        {
+            if (i > 0)
+                output_putc (&out, '\n');
+            output_int (&out, nodes[i]->scc + 1, 0);
+            output_putc (&out, ':');
+        }
+        output_putc (&out, ' ');
+        output_write (&out, nodes[i]->name, (size_t) nodes[i]->namelen);
+    }
+    if (count > 0)
+        output_putc (&out, '\n');
+
+    output_close (&out);
+    free (nodes);
+}
+
+/**
+ * Prints the recursion groups of a graph using the graphviz
+ * conventions. Each group is placed into its own cluster.
+ *
+ * \param graph The graph_t to print.
+ * \param fd The file descriptor to print to.
+ */
+void
+print_graphviz_cycles (graph_t *graph, int fd)
+{
+    output_t out;
+    g_csr_t *csr = &graph->csr;
+    g_node_t *callee = NULL;
+    g_id_t call;
+    long int count = 0;
+    long int i;
+    g_node_t **nodes = get_cycles (graph, &count);
+
+    if (!nodes)
+        return;
+    if (!output_init (&out, fd))
+    {
+        free (nodes);
+        fprintf (stderr, "Memory allocation error\n");
+        return;
+    }
+
+    output_puts (&out, "digraph \"cycles\" {\n");
+    for (i = 0; i < count; i++)
+    {
+        if (i == 0 || nodes[i]->scc != nodes[i - 1]->scc)
+        {
+            if (i > 0)
+                output_write (&out, "  }\n", 4);
+            output_puts (&out, "  subgraph cluster_");
+            output_int (&out, nodes[i]->scc + 1, 0);
+            output_puts (&out, " {\n    label=\"");
+            output_int (&out, nodes[i]->scc + 1, 0);
+            output_write (&out, "\";\n", 3);
+        }
+
+        /* The node and its calls within the group. */
+        output_write (&out, "    ", 4);
+        print_graphviz_node (&out, nodes[i]);
+        output_write (&out, ";\n", 2);
+        for (call = csr->calloffs[nodes[i]->id];
+             call < csr->calloffs[nodes[i]->id + 1]; call++)
+        {
+            callee = csr->nodes[csr->callids[call]];
+            if (callee->scc != nodes[i]->scc || is_hidden (graph, callee))
+                continue;
+            output_write (&out, "    ", 4);
+            print_graphviz_node (&out, nodes[i]);
+            output_write (&out, " -> ", 4);
+            print_graphviz_node (&out, callee);
+            output_write (&out, ";\n", 2);
+        }
+    }
+    if (count > 0)
+        output_write (&out, "  }\n", 4);
+    output_write (&out, "}\n", 2);
 
+    output_close (&out);
+    free (nodes);
 }
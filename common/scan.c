@@ -0,0 +1,703 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include "graph.h"
+
+/* SSE2 is always available on x86-64 and enabled by the compiler for
+ * x86 on demand. AVX2 is compiled in for the function it is used for
+ * and only selected at runtime, if the processor supports it. */
+#if defined(__SSE2__) || defined(_M_X64) || defined(_M_AMD64) || \
+    (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define HAVE_SSE2 1
+#include <emmintrin.h>
+#endif
+#if defined(HAVE_SSE2) && defined(__GNUC__) && \
+    (defined(__x86_64__) || defined(__i386__)) && \
+    (defined(__clang__) || __GNUC__ > 4 || \
+        (__GNUC__ == 4 && __GNUC_MINOR__ >= 9))
+#define HAVE_AVX2 1
+#include <immintrin.h>
+#endif
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+/* Scanner function type. */
+typedef const char* (*scan_func_t) (const char *p, const char *end,
+                                    int *lines);
+typedef const char* (*scan_delim_func_t) (const char *p, const char *end,
+                                          int delim, int *lines);
+
+static const char* scan_spaces_scalar (const char *p, const char *end,
+                                       int *lines);
+static const char* scan_comment_scalar (const char *p, const char *end,
+                                        int *lines);
+static const char* scan_string_scalar (const char *p, const char *end,
+                                       int delim, int *lines);
+static const char* scan_brackets_scalar (const char *p, const char *end,
+                                         int *lines);
+#ifdef HAVE_SSE2
+static inline int first_bit (unsigned int bits);
+static inline int count_bits (unsigned int bits);
+static const char* scan_spaces_sse2 (const char *p, const char *end,
+                                     int *lines);
+static const char* scan_comment_sse2 (const char *p, const char *end,
+                                      int *lines);
+static const char* scan_string_sse2 (const char *p, const char *end,
+                                     int delim, int *lines);
+static const char* scan_brackets_sse2 (const char *p, const char *end,
+                                       int *lines);
+#endif
+#ifdef HAVE_AVX2
+static const char* scan_spaces_avx2 (const char *p, const char *end,
+                                     int *lines);
+static const char* scan_comment_avx2 (const char *p, const char *end,
+                                      int *lines);
+static const char* scan_string_avx2 (const char *p, const char *end,
+                                     int delim, int *lines);
+static const char* scan_brackets_avx2 (const char *p, const char *end,
+                                       int *lines);
+#endif
+
+/* The scanners to use. They are set once by scan_init() and only read
+ * afterwards, so that the lexer threads can share them. */
+#ifdef HAVE_SSE2
+static scan_func_t spaces_func = scan_spaces_sse2;
+static scan_func_t comment_func = scan_comment_sse2;
+static scan_delim_func_t string_func = scan_string_sse2;
+static scan_func_t brackets_func = scan_brackets_sse2;
+#else
+static scan_func_t spaces_func = scan_spaces_scalar;
+static scan_func_t comment_func = scan_comment_scalar;
+static scan_delim_func_t string_func = scan_string_scalar;
+static scan_func_t brackets_func = scan_brackets_scalar;
+#endif
+
+/**
+ * Skips a run of whitespaces byte by byte. Only the whitespaces of the
+ * C locale are skipped.
+ *
+ * \param p The start of the run.
+ * \param end The end of the buffer.
+ * \param lines The amount of newlines skipped is added to it.
+ * \return The first character, which is not a whitespace, or end.
+ */
+static const char*
+scan_spaces_scalar (const char *p, const char *end, int *lines)
+{
+    for (; p < end; p++)
+    {
+        if (*p == '\n')
+            (*lines)++;
+        else if (*p != ' ' && (*p < '\t' || *p > '\r'))
+            break;
+    }
+    return p;
+}
+
+/**
+ * Finds the end of a multiline comment byte by byte.
+ *
+ * \param p The '*' of the opening comment characters.
+ * \param end The end of the buffer.
+ * \param lines The amount of newlines within the comment is added to it.
+ * \return The character after the closing comment characters or NULL, if
+ *         the comment is not closed until the end of the buffer.
+ */
+static const char*
+scan_comment_scalar (const char *p, const char *end, int *lines)
+{
+    for (; end - p > 1; p++)
+    {
+        if (*p == '\n')
+            (*lines)++;
+        else if (*p == '*' && p[1] == '/')
+            return p + 2;
+    }
+    if (p < end && *p == '\n')
+        (*lines)++;
+    return NULL;
+}
+
+/**
+ * Finds the end of a string or character constant byte by byte.
+ *
+ * \param p The start of the constant's contents.
+ * \param end The end of the buffer.
+ * \param delim The closing quote.
+ * \param lines The amount of newlines skipped is added to it.
+ * \return The closing quote, the next backslash or end.
+ */
+static const char*
+scan_string_scalar (const char *p, const char *end, int delim, int *lines)
+{
+    int ch;
+
+    for (; p < end; p++)
+    {
+        ch = (unsigned char) *p;
+        if (ch == '\n')
+            (*lines)++;
+        else if (ch == delim || ch == '\\')
+            break;
+    }
+    return p;
+}
+
+/**
+ * Finds the next bracket, quote, comment or preprocessor character byte
+ * by byte.
+ *
+ * \param p The start of the text.
+ * \param end The end of the buffer.
+ * \param lines The amount of newlines skipped is added to it.
+ * \return The next of '{', '}', '(', ')', '"', '\'', '/' and '#' or end.
+ */
+static const char*
+scan_brackets_scalar (const char *p, const char *end, int *lines)
+{
+    for (; p < end; p++)
+    {
+        switch (*p)
+        {
+        case '\n':
+            (*lines)++;
+            break;
+        case '{':
+        case '}':
+        case '(':
+        case ')':
+        case '"':
+        case '\'':
+        case '/':
+        case '#':
+            return p;
+        }
+    }
+    return p;
+}
+
+#ifdef HAVE_SSE2
+/**
+ * Gets the position of the lowest bit set.
+ *
+ * \param bits The bits to check, which must not be 0.
+ * \return The position of the lowest bit set.
+ */
+static inline int
+first_bit (unsigned int bits)
+{
+#ifdef _MSC_VER
+    unsigned long pos;
+
+    _BitScanForward (&pos, bits);
+    return (int) pos;
+#else
+    return __builtin_ctz (bits);
+#endif
+}
+
+/**
+ * Gets the amount of bits set.
+ *
+ * \param bits The bits to count.
+ * \return The amount of bits set.
+ */
+static inline int
+count_bits (unsigned int bits)
+{
+#ifdef _MSC_VER
+    int count = 0;
+
+    /* __popcnt() would need a check for the instruction. */
+    for (; bits != 0; bits &= bits - 1)
+        count++;
+    return count;
+#else
+    return __builtin_popcount (bits);
+#endif
+}
+
+/**
+ * Skips a run of whitespaces 16 bytes at once.
+ *
+ * \param p The start of the run.
+ * \param end The end of the buffer.
+ * \param lines The amount of newlines skipped is added to it.
+ * \return The first character, which is not a whitespace, or end.
+ */
+static const char*
+scan_spaces_sse2 (const char *p, const char *end, int *lines)
+{
+    const __m128i space = _mm_set1_epi8 (' ');
+    const __m128i tab = _mm_set1_epi8 ('\t');
+    const __m128i range = _mm_set1_epi8 ('\r' - '\t');
+    const __m128i newline = _mm_set1_epi8 ('\n');
+    __m128i data;
+    __m128i ctrl;
+    unsigned int spaces;
+    unsigned int newlines;
+    int pos;
+
+    while (end - p >= 16)
+    {
+        data = _mm_loadu_si128 ((const __m128i *) p);
+        /* '\t' to '\r' are the bytes, which are not larger than the range
+         * after subtracting '\t' as unsigned values. */
+        ctrl = _mm_sub_epi8 (data, tab);
+        spaces = (unsigned int) _mm_movemask_epi8 (_mm_or_si128 (
+            _mm_cmpeq_epi8 (data, space),
+            _mm_cmpeq_epi8 (_mm_min_epu8 (ctrl, range), ctrl)));
+        newlines = (unsigned int) _mm_movemask_epi8 (
+            _mm_cmpeq_epi8 (data, newline));
+        if (spaces != 0xffff)
+        {
+            pos = first_bit (~spaces);
+            *lines += count_bits (newlines & ((1U << pos) - 1));
+            return p + pos;
+        }
+        *lines += count_bits (newlines);
+        p += 16;
+    }
+    return scan_spaces_scalar (p, end, lines);
+}
+
+/**
+ * Finds the end of a multiline comment 16 bytes at once.
+ *
+ * \param p The '*' of the opening comment characters.
+ * \param end The end of the buffer.
+ * \param lines The amount of newlines within the comment is added to it.
+ * \return The character after the closing comment characters or NULL, if
+ *         the comment is not closed until the end of the buffer.
+ */
+static const char*
+scan_comment_sse2 (const char *p, const char *end, int *lines)
+{
+    const __m128i star = _mm_set1_epi8 ('*');
+    const __m128i slash = _mm_set1_epi8 ('/');
+    const __m128i newline = _mm_set1_epi8 ('\n');
+    __m128i data;
+    unsigned int closing;
+    unsigned int newlines;
+    int pos;
+
+    /* The byte after each block is loaded to find a '*' at its end. */
+    while (end - p > 16)
+    {
+        data = _mm_loadu_si128 ((const __m128i *) p);
+        closing = (unsigned int) _mm_movemask_epi8 (_mm_and_si128 (
+            _mm_cmpeq_epi8 (data, star),
+            _mm_cmpeq_epi8 (_mm_loadu_si128 ((const __m128i *) (p + 1)),
+                slash)));
+        newlines = (unsigned int) _mm_movemask_epi8 (
+            _mm_cmpeq_epi8 (data, newline));
+        if (closing != 0)
+        {
+            pos = first_bit (closing);
+            *lines += count_bits (newlines & ((1U << pos) - 1));
+            return p + pos + 2;
+        }
+        *lines += count_bits (newlines);
+        p += 16;
+    }
+    return scan_comment_scalar (p, end, lines);
+}
+
+/**
+ * Finds the end of a string or character constant 16 bytes at once.
+ *
+ * \param p The start of the constant's contents.
+ * \param end The end of the buffer.
+ * \param delim The closing quote.
+ * \param lines The amount of newlines skipped is added to it.
+ * \return The closing quote, the next backslash or end.
+ */
+static const char*
+scan_string_sse2 (const char *p, const char *end, int delim, int *lines)
+{
+    const __m128i quote = _mm_set1_epi8 ((char) delim);
+    const __m128i backslash = _mm_set1_epi8 ('\\');
+    const __m128i newline = _mm_set1_epi8 ('\n');
+    __m128i data;
+    unsigned int stops;
+    unsigned int newlines;
+    int pos;
+
+    while (end - p >= 16)
+    {
+        data = _mm_loadu_si128 ((const __m128i *) p);
+        stops = (unsigned int) _mm_movemask_epi8 (_mm_or_si128 (
+            _mm_cmpeq_epi8 (data, quote),
+            _mm_cmpeq_epi8 (data, backslash)));
+        newlines = (unsigned int) _mm_movemask_epi8 (
+            _mm_cmpeq_epi8 (data, newline));
+        if (stops != 0)
+        {
+            pos = first_bit (stops);
+            *lines += count_bits (newlines & ((1U << pos) - 1));
+            return p + pos;
+        }
+        *lines += count_bits (newlines);
+        p += 16;
+    }
+    return scan_string_scalar (p, end, delim, lines);
+}
+
+/**
+ * Finds the next bracket, quote, comment or preprocessor character 16
+ * bytes at once.
+ *
+ * \param p The start of the text.
+ * \param end The end of the buffer.
+ * \param lines The amount of newlines skipped is added to it.
+ * \return The next of '{', '}', '(', ')', '"', '\'', '/' and '#' or end.
+ */
+static const char*
+scan_brackets_sse2 (const char *p, const char *end, int *lines)
+{
+    const __m128i lbrace = _mm_set1_epi8 ('{');
+    const __m128i rbrace = _mm_set1_epi8 ('}');
+    const __m128i lparen = _mm_set1_epi8 ('(');
+    const __m128i rparen = _mm_set1_epi8 (')');
+    const __m128i dquote = _mm_set1_epi8 ('"');
+    const __m128i squote = _mm_set1_epi8 ('\'');
+    const __m128i slash = _mm_set1_epi8 ('/');
+    const __m128i hash = _mm_set1_epi8 ('#');
+    const __m128i newline = _mm_set1_epi8 ('\n');
+    __m128i data;
+    __m128i found;
+    unsigned int stops;
+    unsigned int newlines;
+    int pos;
+
+    while (end - p >= 16)
+    {
+        data = _mm_loadu_si128 ((const __m128i *) p);
+        found = _mm_or_si128 (
+            _mm_or_si128 (_mm_cmpeq_epi8 (data, lbrace),
+                _mm_cmpeq_epi8 (data, rbrace)),
+            _mm_or_si128 (_mm_cmpeq_epi8 (data, lparen),
+                _mm_cmpeq_epi8 (data, rparen)));
+        found = _mm_or_si128 (found, _mm_or_si128 (
+            _mm_or_si128 (_mm_cmpeq_epi8 (data, dquote),
+                _mm_cmpeq_epi8 (data, squote)),
+            _mm_or_si128 (_mm_cmpeq_epi8 (data, slash),
+                _mm_cmpeq_epi8 (data, hash))));
+        stops = (unsigned int) _mm_movemask_epi8 (found);
+        newlines = (unsigned int) _mm_movemask_epi8 (
+            _mm_cmpeq_epi8 (data, newline));
+        if (stops != 0)
+        {
+            pos = first_bit (stops);
+            *lines += count_bits (newlines & ((1U << pos) - 1));
+            return p + pos;
+        }
+        *lines += count_bits (newlines);
+        p += 16;
+    }
+    return scan_brackets_scalar (p, end, lines);
+}
+#endif /* HAVE_SSE2 */
+
+#ifdef HAVE_AVX2
+/**
+ * Skips a run of whitespaces 32 bytes at once.
+ *
+ * \param p The start of the run.
+ * \param end The end of the buffer.
+ * \param lines The amount of newlines skipped is added to it.
+ * \return The first character, which is not a whitespace, or end.
+ */
+__attribute__((target("avx2,popcnt")))
+static const char*
+scan_spaces_avx2 (const char *p, const char *end, int *lines)
+{
+    const __m256i space = _mm256_set1_epi8 (' ');
+    const __m256i tab = _mm256_set1_epi8 ('\t');
+    const __m256i range = _mm256_set1_epi8 ('\r' - '\t');
+    const __m256i newline = _mm256_set1_epi8 ('\n');
+    __m256i data;
+    __m256i ctrl;
+    unsigned int spaces;
+    unsigned int newlines;
+    int pos;
+
+    while (end - p >= 32)
+    {
+        data = _mm256_loadu_si256 ((const __m256i *) p);
+        ctrl = _mm256_sub_epi8 (data, tab);
+        spaces = (unsigned int) _mm256_movemask_epi8 (_mm256_or_si256 (
+            _mm256_cmpeq_epi8 (data, space),
+            _mm256_cmpeq_epi8 (_mm256_min_epu8 (ctrl, range), ctrl)));
+        newlines = (unsigned int) _mm256_movemask_epi8 (
+            _mm256_cmpeq_epi8 (data, newline));
+        if (spaces != 0xffffffffU)
+        {
+            pos = __builtin_ctz (~spaces);
+            *lines += __builtin_popcount (newlines & ((1U << pos) - 1));
+            return p + pos;
+        }
+        *lines += __builtin_popcount (newlines);
+        p += 32;
+    }
+    return scan_spaces_sse2 (p, end, lines);
+}
+
+/**
+ * Finds the end of a multiline comment 32 bytes at once.
+ *
+ * \param p The '*' of the opening comment characters.
+ * \param end The end of the buffer.
+ * \param lines The amount of newlines within the comment is added to it.
+ * \return The character after the closing comment characters or NULL, if
+ *         the comment is not closed until the end of the buffer.
+ */
+__attribute__((target("avx2,popcnt")))
+static const char*
+scan_comment_avx2 (const char *p, const char *end, int *lines)
+{
+    const __m256i star = _mm256_set1_epi8 ('*');
+    const __m256i slash = _mm256_set1_epi8 ('/');
+    const __m256i newline = _mm256_set1_epi8 ('\n');
+    __m256i data;
+    unsigned int closing;
+    unsigned int newlines;
+    int pos;
+
+    while (end - p > 32)
+    {
+        data = _mm256_loadu_si256 ((const __m256i *) p);
+        closing = (unsigned int) _mm256_movemask_epi8 (_mm256_and_si256 (
+            _mm256_cmpeq_epi8 (data, star),
+            _mm256_cmpeq_epi8 (
+                _mm256_loadu_si256 ((const __m256i *) (p + 1)), slash)));
+        newlines = (unsigned int) _mm256_movemask_epi8 (
+            _mm256_cmpeq_epi8 (data, newline));
+        if (closing != 0)
+        {
+            pos = __builtin_ctz (closing);
+            *lines += __builtin_popcount (newlines & ((1U << pos) - 1));
+            return p + pos + 2;
+        }
+        *lines += __builtin_popcount (newlines);
+        p += 32;
+    }
+    return scan_comment_sse2 (p, end, lines);
+}
+
+/**
+ * Finds the end of a string or character constant 32 bytes at once.
+ *
+ * \param p The start of the constant's contents.
+ * \param end The end of the buffer.
+ * \param delim The closing quote.
+ * \param lines The amount of newlines skipped is added to it.
+ * \return The closing quote, the next backslash or end.
+ */
+__attribute__((target("avx2,popcnt")))
+static const char*
+scan_string_avx2 (const char *p, const char *end, int delim, int *lines)
+{
+    const __m256i quote = _mm256_set1_epi8 ((char) delim);
+    const __m256i backslash = _mm256_set1_epi8 ('\\');
+    const __m256i newline = _mm256_set1_epi8 ('\n');
+    __m256i data;
+    unsigned int stops;
+    unsigned int newlines;
+    int pos;
+
+    while (end - p >= 32)
+    {
+        data = _mm256_loadu_si256 ((const __m256i *) p);
+        stops = (unsigned int) _mm256_movemask_epi8 (_mm256_or_si256 (
+            _mm256_cmpeq_epi8 (data, quote),
+            _mm256_cmpeq_epi8 (data, backslash)));
+        newlines = (unsigned int) _mm256_movemask_epi8 (
+            _mm256_cmpeq_epi8 (data, newline));
+        if (stops != 0)
+        {
+            pos = __builtin_ctz (stops);
+            *lines += __builtin_popcount (newlines & ((1U << pos) - 1));
+            return p + pos;
+        }
+        *lines += __builtin_popcount (newlines);
+        p += 32;
+    }
+    return scan_string_sse2 (p, end, delim, lines);
+}
+
+/**
+ * Finds the next bracket, quote, comment or preprocessor character 32
+ * bytes at once.
+ *
+ * \param p The start of the text.
+ * \param end The end of the buffer.
+ * \param lines The amount of newlines skipped is added to it.
+ * \return The next of '{', '}', '(', ')', '"', '\'', '/' and '#' or end.
+ */
+__attribute__((target("avx2,popcnt")))
+static const char*
+scan_brackets_avx2 (const char *p, const char *end, int *lines)
+{
+    const __m256i lbrace = _mm256_set1_epi8 ('{');
+    const __m256i rbrace = _mm256_set1_epi8 ('}');
+    const __m256i lparen = _mm256_set1_epi8 ('(');
+    const __m256i rparen = _mm256_set1_epi8 (')');
+    const __m256i dquote = _mm256_set1_epi8 ('"');
+    const __m256i squote = _mm256_set1_epi8 ('\'');
+    const __m256i slash = _mm256_set1_epi8 ('/');
+    const __m256i hash = _mm256_set1_epi8 ('#');
+    const __m256i newline = _mm256_set1_epi8 ('\n');
+    __m256i data;
+    __m256i found;
+    unsigned int stops;
+    unsigned int newlines;
+    int pos;
+
+    while (end - p >= 32)
+    {
+        data = _mm256_loadu_si256 ((const __m256i *) p);
+        found = _mm256_or_si256 (
+            _mm256_or_si256 (_mm256_cmpeq_epi8 (data, lbrace),
+                _mm256_cmpeq_epi8 (data, rbrace)),
+            _mm256_or_si256 (_mm256_cmpeq_epi8 (data, lparen),
+                _mm256_cmpeq_epi8 (data, rparen)));
+        found = _mm256_or_si256 (found, _mm256_or_si256 (
+            _mm256_or_si256 (_mm256_cmpeq_epi8 (data, dquote),
+                _mm256_cmpeq_epi8 (data, squote)),
+            _mm256_or_si256 (_mm256_cmpeq_epi8 (data, slash),
+                _mm256_cmpeq_epi8 (data, hash))));
+        stops = (unsigned int) _mm256_movemask_epi8 (found);
+        newlines = (unsigned int) _mm256_movemask_epi8 (
+            _mm256_cmpeq_epi8 (data, newline));
+        if (stops != 0)
+        {
+            pos = __builtin_ctz (stops);
+            *lines += __builtin_popcount (newlines & ((1U << pos) - 1));
+            return p + pos;
+        }
+        *lines += __builtin_popcount (newlines);
+        p += 32;
+    }
+    return scan_brackets_sse2 (p, end, lines);
+}
+#endif /* HAVE_AVX2 */
+
+/**
+ * Selects the fastest scanners for the processor. It must be called
+ * before the first file is lexed and before any lexer threads are
+ * started.
+ */
+void
+scan_init (void)
+{
+#ifdef HAVE_AVX2
+    __builtin_cpu_init ();
+    if (__builtin_cpu_supports ("avx2") &&
+        __builtin_cpu_supports ("popcnt"))
+    {
+        spaces_func = scan_spaces_avx2;
+        comment_func = scan_comment_avx2;
+        string_func = scan_string_avx2;
+        brackets_func = scan_brackets_avx2;
+    }
+#endif
+}
+
+/**
+ * Skips a run of whitespaces and counts the newlines within it. Only the
+ * whitespaces of the C locale are skipped, so that the lexers have to
+ * check the returned character with isspace() again.
+ *
+ * \param p The start of the run.
+ * \param end The end of the buffer.
+ * \param lines The amount of newlines skipped is added to it.
+ * \return The first character, which is not a whitespace, or end.
+ */
+const char*
+scan_spaces (const char *p, const char *end, int *lines)
+{
+    return spaces_func (p, end, lines);
+}
+
+/**
+ * Finds the end of a multiline comment and counts the newlines within
+ * it. The search starts at the '*' of the opening comment characters, so
+ * that "/" + "*" + "/" closes the comment as well.
+ *
+ * \param p The '*' of the opening comment characters.
+ * \param end The end of the buffer.
+ * \param lines The amount of newlines within the comment is added to it.
+ * \return The character after the closing comment characters or NULL, if
+ *         the comment is not closed until the end of the buffer.
+ */
+const char*
+scan_comment (const char *p, const char *end, int *lines)
+{
+    return comment_func (p, end, lines);
+}
+
+/**
+ * Finds the end of a string or character constant and counts the
+ * newlines up to it. The search stops at the closing quote and at the
+ * next backslash, so that the lexers can skip the escaped character on
+ * their own.
+ *
+ * \param p The start of the constant's contents.
+ * \param end The end of the buffer.
+ * \param delim The closing quote.
+ * \param lines The amount of newlines skipped is added to it.
+ * \return The closing quote, the next backslash or end.
+ */
+const char*
+scan_string (const char *p, const char *end, int delim, int *lines)
+{
+    return string_func (p, end, delim, lines);
+}
+
+/**
+ * Finds the next bracket, quote, comment or preprocessor character and
+ * counts the newlines up to it, so that the lexers can skip bracketed
+ * regions without reading their tokens.
+ *
+ * \param p The start of the text.
+ * \param end The end of the buffer.
+ * \param lines The amount of newlines skipped is added to it.
+ * \return The next of '{', '}', '(', ')', '"', '\'', '/' and '#' or end.
+ */
+const char*
+scan_brackets (const char *p, const char *end, int *lines)
+{
+    return brackets_func (p, end, lines);
+}
@@ -0,0 +1,427 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <errno.h>
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _MSC_VER
+#define HAVE_UNIX_SOCKETS 1
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/un.h>
+#include <signal.h>
+#include <unistd.h>
+#endif
+
+#include "graph.h"
+
+/* Maximum length of a request. */
+#define REQUEST_SIZE 4096
+
+/* Maximum amount of files to update with a single request. */
+#define REQUEST_FILES 64
+
+/* Seconds to wait for a client to send its request or to read the
+ * answer. */
+#define REQUEST_TIMEOUT 10
+
+/* Options of a single request. */
+typedef struct _request
+{
+    const char *root;     /* The root function. */
+    int         depth;    /* Maximum depth. */
+    bool_t      reversed; /* Print the callers (-r). */
+    bool_t      statics;  /* Include externals and static data (-i x). */
+    bool_t      privates; /* Include names with a leading underscore
+                           * (-i _). */
+    bool_t      graphviz; /* Print a graphviz graph (-g). */
+    bool_t      cycles;   /* Print the recursion groups (-s). */
+    char       *files[REQUEST_FILES]; /* Changed files to update (-u). */
+    int         count;    /* Amount of changed files. */
+} request_t;
+
+/* Settings to lex the changed files of the requests. */
+typedef struct _updater
+{
+    lex_func_t        lex;   /* The lexer function or NULL. */
+    void             *data;  /* Data to pass to the lexer function. */
+    const logcache_t *cache; /* The cache of the logs or NULL. */
+} updater_t;
+
+#ifdef HAVE_UNIX_SOCKETS
+static char* next_word (char **cur);
+static bool_t parse_request (request_t *req, char *line);
+static bool_t read_request (int fd, char *line, size_t size);
+static void answer_request (graph_t *graph, const request_t *defaults,
+                            const updater_t *updater, int fd);
+static int open_socket (const char *path);
+
+/**
+ * Gets the next whitespace separated word of a request.
+ *
+ * \param cur The current position within the request, which is moved
+ *        behind the word.
+ * \return The NUL-terminated word or NULL, if there are no more words.
+ */
+static char*
+next_word (char **cur)
+{
+    char *word = *cur;
+
+    while (*word == ' ' || *word == '\t' || *word == '\r')
+        word++;
+    if (*word == '\0')
+        return NULL;
+    *cur = word;
+    while (**cur != '\0' && **cur != ' ' && **cur != '\t' && **cur != '\r')
+        (*cur)++;
+    if (**cur != '\0')
+        *(*cur)++ = '\0';
+    return word;
+}
+
+/**
+ * Parses a request, which consists of the printing options of the
+ * command line, e.g. "-r -d 2 -R main", and the changed files to update,
+ * e.g. "-u foo.c".
+ *
+ * \param req The request_t to set the options for.
+ * \param line The NUL-terminated request, which is modified.
+ * \return TRUE on success, FALSE, if the request is invalid.
+ */
+static bool_t
+parse_request (request_t *req, char *line)
+{
+    char *word;
+    char *arg;
+    char *end;
+    long val;
+
+    while ((word = next_word (&line)) != NULL)
+    {
+        if (word[0] != '-' || word[1] == '\0')
+            return FALSE;
+        for (word++; *word != '\0'; word++)
+        {
+            switch (*word)
+            {
+            case 'g':
+                req->graphviz = TRUE;
+                continue;
+            case 'r':
+                req->reversed = TRUE;
+                continue;
+            case 's':
+                req->cycles = TRUE;
+                continue;
+            case 'd':
+            case 'i':
+            case 'R':
+            case 'u':
+                break;
+            default:
+                return FALSE;
+            }
+
+            /* The argument is the rest of the word or the next word. */
+            arg = (word[1] != '\0') ? word + 1 : next_word (&line);
+            if (!arg)
+                return FALSE;
+            if (*word == 'd')
+            {
+                errno = 0;
+                val = strtol (arg, &end, 10);
+                if (*end != '\0' || errno == ERANGE || val < 0 ||
+                    val > INT_MAX)
+                    return FALSE;
+                req->depth = (int) val;
+            }
+            else if (*word == 'i')
+            {
+                if (strcmp (arg, "x") == 0)
+                    req->statics = TRUE;
+                else if (strcmp (arg, "_") == 0)
+                    req->privates = TRUE;
+                else
+                    return FALSE;
+            }
+            else if (*word == 'u')
+            {
+                if (req->count == REQUEST_FILES)
+                    return FALSE;
+                req->files[req->count++] = arg;
+            }
+            else
+                req->root = arg;
+            break;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Reads a request, which is terminated by a newline or the end of the
+ * connection.
+ *
+ * \param fd The connection to read from.
+ * \param line The buffer to read the request into.
+ * \param size The size of the buffer.
+ * \return TRUE on success, FALSE on error or if the request is too long.
+ */
+static bool_t
+read_request (int fd, char *line, size_t size)
+{
+    size_t len = 0;
+    ssize_t count;
+    char *newline;
+
+    while (len < size - 1)
+    {
+        count = read (fd, line + len, size - 1 - len);
+        if (count < 0 && errno == EINTR)
+            continue;
+        if (count < 0)
+            return FALSE;
+        line[len + (size_t) count] = '\0';
+        newline = strchr (line + len, '\n');
+        len += (size_t) count;
+        if (newline)
+        {
+            *newline = '\0';
+            return TRUE;
+        }
+        if (count == 0)
+            return TRUE;
+    }
+    return FALSE;
+}
+
+/**
+ * Answers a single request of a connection. The changed files of the
+ * request are updated, before the graph is printed with the requested
+ * options to the connection.
+ *
+ * \param graph The graph_t to print.
+ * \param defaults The default options, which are used for all options,
+ *        the request does not set.
+ * \param updater The settings to lex the changed files.
+ * \param fd The connection to answer.
+ */
+static void
+answer_request (graph_t *graph, const request_t *defaults,
+                const updater_t *updater, int fd)
+{
+    request_t req = *defaults;
+    char line[REQUEST_SIZE];
+    const char *msg = NULL;
+    int failed = 0;
+
+    if (!read_request (fd, line, sizeof (line)) ||
+        !parse_request (&req, line))
+        msg = "error: invalid request\n";
+    else if (req.count > 0 && (!updater->lex ||
+        !update_graph (graph, req.files, req.count, 1, updater->lex,
+            updater->data, updater->cache, &failed) || failed > 0))
+        msg = "error: update failed\n";
+    if (msg)
+    {
+        (void) write (fd, msg, strlen (msg));
+        return;
+    }
+
+    set_graph_root (graph, req.root);
+    graph->depth = req.depth;
+    graph->reversed = req.reversed;
+    graph->statics = req.statics;
+    graph->privates = req.privates;
+    if (req.cycles)
+    {
+        if (!req.graphviz)
+            print_cycles (graph, fd);
+        else
+            print_graphviz_cycles (graph, fd);
+    }
+    else if (!req.graphviz)
+        print_graph (graph, fd);
+    else
+        print_graphviz_graph (graph, fd);
+
+    /* The root of the request points into the request buffer, but the
+     * graph keeps it for the updates of the next requests. */
+    set_graph_root (graph, defaults->root);
+    graph->depth = defaults->depth;
+    graph->reversed = defaults->reversed;
+    graph->statics = defaults->statics;
+    graph->privates = defaults->privates;
+}
+
+/**
+ * Creates the listening Unix domain socket. A stale socket of a previous
+ * server is replaced. The socket is only accessible by the user.
+ *
+ * \param path The path of the socket.
+ * \return The socket or -1 on error.
+ */
+static int
+open_socket (const char *path)
+{
+    struct sockaddr_un addr;
+    struct stat st;
+    mode_t mask;
+    int fd;
+    int rc;
+
+    if (strlen (path) >= sizeof (addr.sun_path))
+    {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    memset (&addr, 0, sizeof (addr));
+    addr.sun_family = AF_UNIX;
+    strcpy (addr.sun_path, path);
+
+    if (lstat (path, &st) == 0 && S_ISSOCK (st.st_mode))
+        unlink (path);
+
+    fd = socket (AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1)
+        return -1;
+    mask = umask (S_IRWXG | S_IRWXO);
+    rc = bind (fd, (struct sockaddr*) &addr, sizeof (addr));
+    umask (mask);
+    if (rc == -1 || listen (fd, SOMAXCONN) == -1)
+    {
+        int error = errno;
+        close (fd);
+        errno = error;
+        return -1;
+    }
+    return fd;
+}
+#endif
+
+/**
+ * Serves queries for a graph on a Unix domain socket. The graph is kept
+ * in memory and each connection sends a single line with the printing
+ * options of the command line (-d num, -g, -i incl, -r, -R root, -s).
+ * The graph is printed with these options to the connection, which is
+ * closed afterwards. Options, which are not sent, keep the values of
+ * the graph, which were set on the command line.
+ * Using -u file, a changed file is updated in the graph using
+ * update_graph() before printing it. The requests are answered one after another and
+ * the function only returns on errors.
+ *
+ * \param graph The graph_t to serve.
+ * \param path The path of the socket to create.
+ * \param lex The lexer function for changed files or NULL, if the graph
+ *        cannot be updated.
+ * \param data The data to pass to the lexer function.
+ * \param cache The cache of the logs or NULL.
+ * \return FALSE on error.
+ */
+bool_t
+serve_graph (graph_t *graph, const char *path, lex_func_t lex, void *data,
+             const logcache_t *cache)
+{
+#ifdef HAVE_UNIX_SOCKETS
+    request_t defaults;
+    updater_t updater;
+    struct timeval timeout;
+    int sock;
+    int fd;
+
+    /* Options, which a request does not set, keep the values of the
+     * command line. */
+    defaults.root = graph->root;
+    defaults.depth = graph->depth;
+    defaults.reversed = graph->reversed;
+    defaults.statics = graph->statics;
+    defaults.privates = graph->privates;
+    defaults.graphviz = FALSE;
+    defaults.cycles = FALSE;
+    defaults.count = 0;
+    updater.lex = lex;
+    updater.data = data;
+    updater.cache = cache;
+
+    /* Freeze the graph once, so that the requests only print it. */
+    if (!freeze_graph (graph))
+        return FALSE;
+
+    sock = open_socket (path);
+    if (sock == -1)
+    {
+        perror (path);
+        return FALSE;
+    }
+
+    /* Clients, which close the connection early, must not terminate
+     * the server. */
+    signal (SIGPIPE, SIG_IGN);
+
+    while (TRUE)
+    {
+        fd = accept (sock, NULL, NULL);
+        if (fd == -1)
+        {
+            if (errno == EINTR || errno == ECONNABORTED)
+                continue;
+            perror (path);
+            break;
+        }
+
+        /* A client, which neither sends its request nor reads the
+         * answer, must not block the server. */
+        timeout.tv_sec = REQUEST_TIMEOUT;
+        timeout.tv_usec = 0;
+        (void) setsockopt (fd, SOL_SOCKET, SO_RCVTIMEO, &timeout,
+            sizeof (timeout));
+        (void) setsockopt (fd, SOL_SOCKET, SO_SNDTIMEO, &timeout,
+            sizeof (timeout));
+        answer_request (graph, &defaults, &updater, fd);
+        close (fd);
+    }
+    close (sock);
+    return FALSE;
+#else
+    (void) graph;
+    (void) lex;
+    (void) data;
+    (void) cache;
+    fprintf (stderr, "%s: Unix domain sockets are not supported\n", path);
+    return FALSE;
+#endif
+}
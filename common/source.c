@@ -0,0 +1,251 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifndef _MSC_VER
+#define HAVE_MMAP 1
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+#include "graph.h"
+
+/* Initial size of the buffer for files, which can not be mapped. */
+#define SOURCE_BLOCK_SIZE (256 * 1024)
+
+static bool_t read_stream (source_t *src, FILE *fp);
+
+/**
+ * Reads the complete contents of a stream into the source buffer. The
+ * buffer is doubled in size, whenever it is exhausted.
+ *
+ * \param src The source_t to read the contents into.
+ * \param fp The stream to read from.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+read_stream (source_t *src, FILE *fp)
+{
+    char *data = NULL;
+    char *tmp = NULL;
+    size_t size = 0;
+    size_t len = 0;
+    size_t count;
+
+    do
+    {
+        if (len == size)
+        {
+            size = (size) ? size * 2 : SOURCE_BLOCK_SIZE;
+            tmp = realloc (data, size);
+            if (!tmp)
+            {
+                free (data);
+                errno = ENOMEM;
+                return FALSE;
+            }
+            data = tmp;
+        }
+        count = fread (data + len, 1, size - len, fp);
+        len += count;
+    }
+    while (count > 0);
+
+    if (ferror (fp))
+    {
+        free (data);
+        return FALSE;
+    }
+
+    src->data = data;
+    src->len = len;
+    src->mapped = FALSE;
+    src->owned = TRUE;
+    return TRUE;
+}
+
+/**
+ * Opens a file and makes its contents available in memory. Regular
+ * files are mapped into memory, if possible, any other file, such as a
+ * pipe, is read completely. A filename of "-" denotes the standard
+ * input.
+ *
+ * \param src The source_t to initialize.
+ * \param filename The name of the file to open.
+ * \return TRUE on success, FALSE on error. errno will be set
+ *         accordingly.
+ */
+bool_t
+source_open (source_t *src, const char *filename)
+{
+    FILE *fp;
+    bool_t retval;
+
+    src->data = NULL;
+    src->len = 0;
+    src->mapped = FALSE;
+    src->owned = FALSE;
+
+    if (strcmp (filename, "-") == 0)
+        retval = read_stream (src, stdin);
+    else
+    {
+#ifdef HAVE_MMAP
+        struct stat st;
+        int fd = open (filename, O_RDONLY);
+
+        if (fd == -1)
+            return FALSE;
+        if (fstat (fd, &st) == 0 && S_ISREG (st.st_mode) && st.st_size > 0)
+        {
+            void *data = mmap (NULL, (size_t) st.st_size, PROT_READ,
+                MAP_PRIVATE, fd, 0);
+            if (data != MAP_FAILED)
+            {
+                close (fd);
+                src->data = data;
+                src->len = (size_t) st.st_size;
+                src->mapped = TRUE;
+                src->owned = TRUE;
+                src->cur = src->data;
+                src->end = src->data + src->len;
+                return TRUE;
+            }
+        }
+        fp = fdopen (fd, "r");
+        if (!fp)
+        {
+            close (fd);
+            return FALSE;
+        }
+#else
+        fp = fopen (filename, "r");
+        if (!fp)
+            return FALSE;
+#endif
+        retval = read_stream (src, fp);
+        fclose (fp);
+    }
+    if (!retval)
+        return FALSE;
+
+    src->cur = src->data;
+    src->end = src->data + src->len;
+    return TRUE;
+}
+
+/**
+ * Opens a file like source_open(), but always reads its contents into
+ * memory instead of mapping it. A mapped file raises SIGBUS, if it is
+ * truncated by another process, while it is scanned, so files, which
+ * may be written concurrently, have to be opened this way.
+ *
+ * \param src The source_t to initialize.
+ * \param filename The name of the file to open.
+ * \return TRUE on success, FALSE on error. errno will be set
+ *         accordingly.
+ */
+bool_t
+source_read (source_t *src, const char *filename)
+{
+    FILE *fp;
+    bool_t retval;
+
+    if (strcmp (filename, "-") == 0)
+        return source_open (src, filename);
+
+    src->data = NULL;
+    src->len = 0;
+    src->mapped = FALSE;
+    src->owned = FALSE;
+
+    fp = fopen (filename, "r");
+    if (!fp)
+        return FALSE;
+    retval = read_stream (src, fp);
+    fclose (fp);
+    if (!retval)
+        return FALSE;
+
+    src->cur = src->data;
+    src->end = src->data + src->len;
+    return TRUE;
+}
+
+/**
+ * Initializes a source_t for a buffer of the caller, which allows
+ * the lexers to create a graph from memory. The buffer is not copied and
+ * must stay valid, until the source is not used anymore.
+ *
+ * \param src The source_t to initialize.
+ * \param data The contents to scan, which do not need to be
+ *        NUL-terminated.
+ * \param len The length of the contents.
+ */
+void
+source_init_buffer (source_t *src, const char *data, size_t len)
+{
+    src->data = (char*) data;
+    src->len = len;
+    src->mapped = FALSE;
+    src->owned = FALSE;
+    src->cur = src->data;
+    src->end = src->data + len;
+}
+
+/**
+ * Releases the contents of a source_t.
+ *
+ * \param src The source_t to close.
+ */
+void
+source_close (source_t *src)
+{
+#ifdef HAVE_MMAP
+    if (src->mapped)
+        munmap (src->data, src->len);
+    else
+#endif
+    if (src->owned)
+        free (src->data);
+    src->data = NULL;
+    src->len = 0;
+    src->cur = NULL;
+    src->end = NULL;
+}
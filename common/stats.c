@@ -0,0 +1,272 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef _MSC_VER
+#define HAVE_RUSAGE 1
+#include <sys/time.h>
+#include <sys/resource.h>
+#endif
+
+#include "graph.h"
+
+/* Initial amount of files of the statistics. */
+#define STATS_INITIAL_SIZE 64
+
+static void write_string (FILE *fp, const char *str);
+static void write_counts (FILE *fp, const filestats_t *file,
+                          const char *indent);
+static long get_peak_memory (void);
+
+/**
+ * Initializes empty statistics and starts the time of the run.
+ *
+ * \param stats The stats_t to initialize.
+ */
+void
+stats_init (stats_t *stats)
+{
+    memset (stats, 0, sizeof (stats_t));
+    stats->files = NULL;
+    stats->total.file = NULL;
+    stats->start = stats_time ();
+}
+
+/**
+ * Frees the statistics of the files, but not the stats_t itself.
+ *
+ * \param stats The stats_t to free.
+ */
+void
+stats_free (stats_t *stats)
+{
+    free (stats->files);
+    stats->files = NULL;
+    stats->count = 0;
+    stats->size = 0;
+}
+
+/**
+ * Gets the current time of a monotonic clock.
+ *
+ * \return The time in seconds.
+ */
+double
+stats_time (void)
+{
+#if defined(CLOCK_MONOTONIC)
+    struct timespec ts;
+
+    if (clock_gettime (CLOCK_MONOTONIC, &ts) == 0)
+        return (double) ts.tv_sec + (double) ts.tv_nsec / 1e9;
+#endif
+    return (double) clock () / CLOCKS_PER_SEC;
+}
+
+/**
+ * Adds the statistics of a file. The times, the tokens, identifiers and
+ * nodes of the file are added to the totals, which are not updated by
+ * the graph functions.
+ *
+ * \param stats The stats_t to add the file to.
+ * \param file The statistics of the file.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+bool_t
+stats_add_file (stats_t *stats, const filestats_t *file)
+{
+    if (stats->count == stats->size)
+    {
+        size_t size = (stats->size) ? stats->size * 2 : STATS_INITIAL_SIZE;
+        filestats_t *files = realloc (stats->files,
+            size * sizeof (filestats_t));
+        if (!files)
+        {
+            fprintf (stderr, "Memory allocation error\n");
+            return FALSE;
+        }
+        stats->files = files;
+        stats->size = size;
+    }
+    stats->files[stats->count++] = *file;
+    stats->total.lextime += file->lextime;
+    stats->total.buildtime += file->buildtime;
+    stats->total.tokens += file->tokens;
+    stats->total.identifiers += file->identifiers;
+    stats->total.nodes += file->nodes;
+    return TRUE;
+}
+
+/**
+ * Writes a string as JSON string.
+ *
+ * \param fp The FILE to write to.
+ * \param str The NUL-terminated string to write.
+ */
+static void
+write_string (FILE *fp, const char *str)
+{
+    const unsigned char *cur;
+
+    fputc ('"', fp);
+    for (cur = (const unsigned char*) str; *cur; cur++)
+    {
+        if (*cur == '"' || *cur == '\\')
+            fprintf (fp, "\\%c", *cur);
+        else if (*cur < 0x20)
+            fprintf (fp, "\\u%04x", *cur);
+        else
+            fputc (*cur, fp);
+    }
+    fputc ('"', fp);
+}
+
+/**
+ * Writes the times and counters of a file or the totals as members of a
+ * JSON object.
+ *
+ * \param fp The FILE to write to.
+ * \param file The statistics to write.
+ * \param indent The indentation of the members.
+ */
+static void
+write_counts (FILE *fp, const filestats_t *file, const char *indent)
+{
+    /* The lookups are part of the operations, which are replayed. */
+    fprintf (fp, "%s\"lex_seconds\": %.6f,\n", indent, file->lextime);
+    fprintf (fp, "%s\"build_seconds\": %.6f,\n", indent,
+        file->buildtime - file->lookuptime);
+    fprintf (fp, "%s\"lookup_seconds\": %.6f,\n", indent,
+        file->lookuptime);
+    fprintf (fp, "%s\"tokens\": %lu,\n", indent,
+        (unsigned long) file->tokens);
+    fprintf (fp, "%s\"identifiers\": %lu,\n", indent,
+        (unsigned long) file->identifiers);
+    fprintf (fp, "%s\"definitions\": %lu,\n", indent,
+        (unsigned long) file->definitions);
+    fprintf (fp, "%s\"nodes\": %lu,\n", indent,
+        (unsigned long) file->nodes);
+    fprintf (fp, "%s\"edges\": %lu,\n", indent,
+        (unsigned long) file->edges);
+    fprintf (fp, "%s\"duplicate_edges\": %lu,\n", indent,
+        (unsigned long) file->duplicates);
+    fprintf (fp, "%s\"lookups\": %lu", indent,
+        (unsigned long) file->lookups);
+}
+
+/**
+ * Gets the peak resident memory of the process.
+ *
+ * \return The peak memory in kilobytes or -1, if it is not available.
+ */
+static long
+get_peak_memory (void)
+{
+#ifdef HAVE_RUSAGE
+    struct rusage usage;
+
+    if (getrusage (RUSAGE_SELF, &usage) != 0)
+        return -1;
+#ifdef __APPLE__
+    /* Darwin reports bytes instead of kilobytes. */
+    return (long) (usage.ru_maxrss / 1024);
+#else
+    return (long) usage.ru_maxrss;
+#endif
+#else
+    return -1;
+#endif
+}
+
+/**
+ * Writes the statistics of the run as JSON object. The build times do
+ * not include the times of the lookups, which are reported on their own.
+ *
+ * \param stats The stats_t to write.
+ * \param program The name of the program.
+ * \param jobs The amount of threads used for lexing.
+ * \param filename The file to write to or "-" for the standard error.
+ * \return TRUE on success, FALSE on error.
+ */
+bool_t
+write_stats (stats_t *stats, const char *program, int jobs,
+             const char *filename)
+{
+    FILE *fp = stderr;
+    size_t i;
+    bool_t retval = TRUE;
+
+    if (strcmp (filename, "-") != 0)
+    {
+        fp = fopen (filename, "w");
+        if (!fp)
+        {
+            perror (filename);
+            return FALSE;
+        }
+    }
+
+    fprintf (fp, "{\n  \"program\": ");
+    write_string (fp, program);
+    fprintf (fp, ",\n  \"jobs\": %d,\n", jobs);
+    fprintf (fp, "  \"files\": %lu,\n", (unsigned long) stats->count);
+    fprintf (fp, "  \"total_seconds\": %.6f,\n",
+        stats_time () - stats->start);
+    fprintf (fp, "  \"print_seconds\": %.6f,\n", stats->printtime);
+    fprintf (fp, "  \"peak_memory_kb\": %ld,\n", get_peak_memory ());
+    fprintf (fp, "  \"total\": {\n");
+    write_counts (fp, &stats->total, "    ");
+    fprintf (fp, "\n  },\n  \"per_file\": [");
+    for (i = 0; i < stats->count; i++)
+    {
+        fprintf (fp, "%s\n    {\n      \"file\": ", (i > 0) ? "," : "");
+        write_string (fp, stats->files[i].file);
+        fprintf (fp, ",\n      \"cached\": %s,\n",
+            (stats->files[i].cached) ? "true" : "false");
+        write_counts (fp, &stats->files[i], "      ");
+        fprintf (fp, "\n    }");
+    }
+    fprintf (fp, "%s]\n}\n", (stats->count > 0) ? "\n  " : "");
+
+    if (ferror (fp))
+        retval = FALSE;
+    if (fp != stderr && fclose (fp) != 0)
+        retval = FALSE;
+    if (!retval)
+        perror (filename);
+    return retval;
+}
@@ -0,0 +1,342 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <string.h>
+#include <stdlib.h>
+
+#include "graph.h"
+
+/* Initial amount of slots for the string table. */
+#define STRTAB_INITIAL_SIZE 1024
+
+static inline unsigned int hash_bytes (unsigned int hash, const char *str,
+                                       size_t len);
+static bool_t grow_strtab (strtab_t *tab);
+static istr_t** lookup_slot (strtab_t *tab, unsigned int hash,
+                             const char *first, size_t firstlen,
+                             const char *second, size_t secondlen);
+static char* intern_hashed (strtab_t *tab, unsigned int hash,
+                            const char *first, size_t firstlen,
+                            const char *second, size_t secondlen);
+static char* intern_parts (strtab_t *tab, const char *first,
+                           size_t firstlen, const char *second,
+                           size_t secondlen);
+
+/**
+ * Continues a FNV-1a hash value calculation for the passed bytes.
+ *
+ * \param hash The hash value to continue with.
+ * \param str The bytes to hash.
+ * \param len The amount of bytes to hash.
+ * \return The updated hash value.
+ */
+static inline unsigned int
+hash_bytes (unsigned int hash, const char *str, size_t len)
+{
+    while (len--)
+    {
+        hash ^= (unsigned char) *str++;
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+/**
+ * Doubles the amount of slots of the passed string table and rehashes
+ * the existing strings.
+ *
+ * \param tab The strtab_t to grow.
+ * \return TRUE on success, FALSE in case of an error.
+ */
+static bool_t
+grow_strtab (strtab_t *tab)
+{
+    size_t i;
+    size_t size = (tab->size) ? tab->size * 2 : STRTAB_INITIAL_SIZE;
+    istr_t **old = tab->slots;
+    istr_t **slots = calloc (size, sizeof (istr_t *));
+    if (!slots)
+        return FALSE;
+
+    for (i = 0; i < tab->size; i++)
+    {
+        size_t pos;
+        if (!old[i])
+            continue;
+        pos = old[i]->hash & (size - 1);
+        while (slots[pos])
+            pos = (pos + 1) & (size - 1);
+        slots[pos] = old[i];
+    }
+
+    free (old);
+    tab->slots = slots;
+    tab->size = size;
+    return TRUE;
+}
+
+/**
+ * Gets the slot of the string table, which holds the concatenation of
+ * the passed string parts or the empty slot, in which it would be
+ * placed.
+ *
+ * \param tab The strtab_t to search.
+ * \param hash The hash value of the concatenated parts.
+ * \param first The first part of the string.
+ * \param firstlen The length of the first part.
+ * \param second The second part of the string or NULL.
+ * \param secondlen The length of the second part.
+ * \return The slot for the string.
+ */
+static istr_t**
+lookup_slot (strtab_t *tab, unsigned int hash, const char *first,
+             size_t firstlen, const char *second, size_t secondlen)
+{
+    size_t pos = hash & (tab->size - 1);
+    istr_t *cur;
+
+    while ((cur = tab->slots[pos]) != NULL)
+    {
+        if (cur->hash == hash && (size_t) cur->len == firstlen + secondlen &&
+            memcmp (cur->str, first, firstlen) == 0 &&
+            (!secondlen || memcmp (cur->str + firstlen, second,
+                secondlen) == 0))
+            break;
+        pos = (pos + 1) & (tab->size - 1);
+    }
+    return &tab->slots[pos];
+}
+
+/**
+ * Interns the concatenation of the passed string parts, for which the
+ * hash value was calculated already.
+ *
+ * \param tab The strtab_t to intern the string in.
+ * \param hash The hash value of the concatenated parts.
+ * \param first The first part of the string.
+ * \param firstlen The length of the first part.
+ * \param second The second part of the string or NULL.
+ * \param secondlen The length of the second part.
+ * \return The interned string or NULL in case of an error.
+ */
+static char*
+intern_hashed (strtab_t *tab, unsigned int hash, const char *first,
+               size_t firstlen, const char *second, size_t secondlen)
+{
+    istr_t **slot;
+    istr_t *add;
+
+    /* Keep the load factor below 1/2 to keep the probe chains short. */
+    if ((tab->used + 1) * 2 > tab->size)
+    {
+        if (!grow_strtab (tab))
+            return NULL;
+    }
+
+    slot = lookup_slot (tab, hash, first, firstlen, second, secondlen);
+    if (*slot)
+        return (*slot)->str;
+
+    add = arena_alloc (tab->arena, sizeof (istr_t) + firstlen + secondlen);
+    if (!add)
+        return NULL;
+    add->hash = hash;
+    add->len = (int) (firstlen + secondlen);
+    memcpy (add->str, first, firstlen);
+    if (secondlen)
+        memcpy (add->str + firstlen, second, secondlen);
+    add->str[add->len] = '\0';
+
+    *slot = add;
+    tab->used++;
+    return add->str;
+}
+
+/**
+ * Interns the concatenation of the passed string parts.
+ *
+ * \param tab The strtab_t to intern the string in.
+ * \param first The first part of the string.
+ * \param firstlen The length of the first part.
+ * \param second The second part of the string or NULL.
+ * \param secondlen The length of the second part.
+ * \return The interned string or NULL in case of an error.
+ */
+static char*
+intern_parts (strtab_t *tab, const char *first, size_t firstlen,
+              const char *second, size_t secondlen)
+{
+    unsigned int hash = hash_bytes (hash_bytes (2166136261U, first,
+        firstlen), second, secondlen);
+    return intern_hashed (tab, hash, first, firstlen, second, secondlen);
+}
+
+/**
+ * Initializes an empty string table.
+ *
+ * \param tab The strtab_t to initialize.
+ * \param arena The arena to allocate the strings from.
+ */
+void
+strtab_init (strtab_t *tab, arena_t *arena)
+{
+    tab->arena = arena;
+    tab->slots = NULL;
+    tab->size = 0;
+    tab->used = 0;
+}
+
+/**
+ * Interns a string. Equal strings interned in the same table share the
+ * same memory, so that they can be compared by their address.
+ *
+ * \param tab The strtab_t to intern the string in.
+ * \param str The NUL-terminated string to intern.
+ * \return The interned string or NULL in case of an error.
+ */
+char*
+strtab_intern (strtab_t *tab, const char *str)
+{
+    return intern_parts (tab, str, strlen (str), NULL, 0);
+}
+
+/**
+ * Interns the first len bytes of a string, which does not need to be
+ * NUL-terminated.
+ *
+ * \param tab The strtab_t to intern the string in.
+ * \param str The string to intern.
+ * \param len The amount of bytes to intern.
+ * \return The interned string or NULL in case of an error.
+ */
+char*
+strtab_intern_len (strtab_t *tab, const char *str, size_t len)
+{
+    return intern_parts (tab, str, len, NULL, 0);
+}
+
+/**
+ * Interns a string, which was interned in another string table
+ * already. The hash value and length of the string are taken over.
+ *
+ * \param tab The strtab_t to intern the string in.
+ * \param str The string, interned by another strtab_t.
+ * \return The interned string or NULL in case of an error.
+ */
+char*
+strtab_import (strtab_t *tab, const char *str)
+{
+    istr_t *istr = ISTR (str);
+    return intern_hashed (tab, istr->hash, istr->str, (size_t) istr->len,
+        NULL, 0);
+}
+
+/**
+ * Interns the concatenation of two strings without the need to create
+ * the concatenated string beforehand.
+ *
+ * \param tab The strtab_t to intern the string in.
+ * \param first The first NUL-terminated string.
+ * \param second The NUL-terminated string to append to the first one.
+ * \return The interned string or NULL in case of an error.
+ */
+char*
+strtab_intern_concat (strtab_t *tab, const char *first, const char *second)
+{
+    return intern_parts (tab, first, strlen (first), second, strlen (second));
+}
+
+/**
+ * Gets the interned version of a string without interning it.
+ *
+ * \param tab The strtab_t to search.
+ * \param str The NUL-terminated string to search for.
+ * \return The interned string or NULL, if the string was not interned.
+ */
+char*
+strtab_lookup (strtab_t *tab, const char *str)
+{
+    return strtab_lookup_len (tab, str, strlen (str));
+}
+
+/**
+ * Gets the interned version of the first len bytes of a string without
+ * interning it.
+ *
+ * \param tab The strtab_t to search.
+ * \param str The string to search for.
+ * \param len The amount of bytes to search for.
+ * \return The interned string or NULL, if the string was not interned.
+ */
+char*
+strtab_lookup_len (strtab_t *tab, const char *str, size_t len)
+{
+    istr_t **slot;
+
+    if (!tab->size)
+        return NULL;
+    slot = lookup_slot (tab, hash_bytes (2166136261U, str, len), str, len,
+        NULL, 0);
+    return (*slot) ? (*slot)->str : NULL;
+}
+
+/**
+ * Gets the slot of a string, which was interned by the string table.
+ * The slot identifies the string within the table, as long as no
+ * further strings are interned.
+ *
+ * \param tab The strtab_t, which interned the string.
+ * \param str The interned string.
+ * \return The slot of the string.
+ */
+size_t
+strtab_slot (strtab_t *tab, const char *str)
+{
+    size_t pos = ISTR (str)->hash & (tab->size - 1);
+
+    while (tab->slots[pos]->str != str)
+        pos = (pos + 1) & (tab->size - 1);
+    return pos;
+}
+
+/**
+ * Frees the hash slots of a string table. The strings themselves are
+ * released with the arena of the table.
+ *
+ * \param tab The strtab_t to free.
+ */
+void
+strtab_free (strtab_t *tab)
+{
+    free (tab->slots);
+    strtab_init (tab, tab->arena);
+}
@@ -0,0 +1,371 @@
+/*-
+ * Copyright (c) 2026, Marcus von Appen
+ * All rights reserved.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions
+ * are met:
+ * 1. Redistributions of source code must retain the above copyright
+ *    notice, this list of conditions and the following disclaimer 
+ *    in this position and unchanged.
+ * 2. Redistributions in binary form must reproduce the above copyright
+ *    notice, this list of conditions and the following disclaimer in the
+ *    documentation and/or other materials provided with the distribution.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE AUTHOR ``AS IS'' AND ANY EXPRESS OR
+ * IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED TO, THE IMPLIED WARRANTIES
+ * OF MERCHANTABILITY AND FITNESS FOR A PARTICULAR PURPOSE ARE DISCLAIMED.
+ * IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE,
+ * DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY
+ * THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+
+
+#ifdef __FreeBSD__
+#include <sys/cdefs.h>
+__FBSDID("$FreeBSD$");
+#endif
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef __linux__
+#define HAVE_INOTIFY 1
+#include <sys/inotify.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#include "graph.h"
+
+#ifdef HAVE_INOTIFY
+/* Time in milliseconds without further changes, before the changed files
+ * are processed. Editors and build tools often write a file in several
+ * steps. */
+#define WATCH_DELAY 100
+
+/* Events of a watched directory, which change one of its files. Editors,
+ * which replace a file by renaming a new one, do not change the file
+ * itself, so its directory is watched instead. */
+#define WATCH_EVENTS \
+    (IN_CLOSE_WRITE | IN_MOVED_TO | IN_MOVED_FROM | IN_DELETE | IN_ONLYDIR)
+
+/* A watched input file. */
+typedef struct _watched
+{
+    char       *file;    /* The name of the file. */
+    const char *base;    /* The name of the file within its directory. */
+    int         wd;      /* The watch of the directory. */
+    bool_t      changed; /* Indicates, whether the file changed. */
+} watched_t;
+
+static bool_t write_output (graph_t *graph, print_func_t print,
+                            const char *output);
+static bool_t add_watches (int fd, watched_t *watched, int count);
+static bool_t read_events (int fd, watched_t *watched, int count);
+static bool_t wait_events (int fd, watched_t *watched, int count);
+static bool_t update_files (graph_t *graph, watched_t *watched, int count,
+                            char **changed, int jobs, lex_func_t lex,
+                            void *data, const logcache_t *cache);
+
+/**
+ * Prints the graph to the output file. The output is written under a
+ * temporary name first and renamed afterwards, so that readers of the
+ * file never see a partially written graph.
+ *
+ * \param graph The graph_t to print.
+ * \param print The printing function to use.
+ * \param output The name of the output file.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+write_output (graph_t *graph, print_func_t print, const char *output)
+{
+    size_t len = strlen (output) + 32;
+    char *tmppath;
+    int fd;
+    bool_t retval = FALSE;
+
+    tmppath = malloc (len);
+    if (!tmppath)
+    {
+        fprintf (stderr, "Memory allocation error\n");
+        return FALSE;
+    }
+    snprintf (tmppath, len, "%s.%ld.tmp", output, (long) getpid ());
+    fd = open (tmppath, O_WRONLY | O_CREAT | O_TRUNC, 0666);
+    if (fd != -1)
+    {
+        print (graph, fd);
+        if (close (fd) == 0 && rename (tmppath, output) == 0)
+            retval = TRUE;
+        else
+            remove (tmppath);
+    }
+    if (!retval)
+        perror (output);
+    free (tmppath);
+    return retval;
+}
+
+/**
+ * Watches the directories of the input files. Files of the same
+ * directory share the watch of the directory.
+ *
+ * \param fd The inotify instance.
+ * \param watched The files to watch.
+ * \param count The amount of files.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+add_watches (int fd, watched_t *watched, int count)
+{
+    const char *slash;
+    char *dir;
+    size_t len;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        slash = strrchr (watched[i].file, '/');
+        watched[i].base = (slash) ? slash + 1 : watched[i].file;
+        if (!slash)
+            len = 0;
+        else
+            len = (slash == watched[i].file) ? 1 :
+                (size_t) (slash - watched[i].file);
+
+        dir = malloc (len + 2);
+        if (!dir)
+        {
+            fprintf (stderr, "Memory allocation error\n");
+            return FALSE;
+        }
+        if (len > 0)
+        {
+            memcpy (dir, watched[i].file, len);
+            dir[len] = '\0';
+        }
+        else
+            strcpy (dir, ".");
+
+        watched[i].wd = inotify_add_watch (fd, dir, WATCH_EVENTS);
+        if (watched[i].wd == -1)
+        {
+            perror (dir);
+            free (dir);
+            return FALSE;
+        }
+        free (dir);
+    }
+    return TRUE;
+}
+
+/**
+ * Reads the pending events and marks the files, which changed.
+ *
+ * \param fd The inotify instance.
+ * \param watched The watched files.
+ * \param count The amount of files.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+read_events (int fd, watched_t *watched, int count)
+{
+    union
+    {
+        struct inotify_event event;
+        char data[4096 + sizeof (struct inotify_event)];
+    } buf;
+    const struct inotify_event *ev;
+    ssize_t len;
+    ssize_t pos;
+    int i;
+
+    do
+        len = read (fd, buf.data, sizeof (buf.data));
+    while (len == -1 && errno == EINTR);
+    if (len <= 0)
+        return FALSE;
+
+    for (pos = 0; pos < len;
+         pos += (ssize_t) (sizeof (struct inotify_event) + ev->len))
+    {
+        ev = (const struct inotify_event*) (buf.data + pos);
+        for (i = 0; i < count; i++)
+        {
+            /* Events were lost, so that everything may have changed. */
+            if (ev->mask & IN_Q_OVERFLOW)
+                watched[i].changed = TRUE;
+            else if (ev->len > 0 && watched[i].wd == ev->wd &&
+                strcmp (watched[i].base, ev->name) == 0)
+                watched[i].changed = TRUE;
+        }
+    }
+    return TRUE;
+}
+
+/**
+ * Waits for changes of the watched files and reads the events, until no
+ * further events arrive for WATCH_DELAY milliseconds.
+ *
+ * \param fd The inotify instance.
+ * \param watched The watched files.
+ * \param count The amount of files.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+wait_events (int fd, watched_t *watched, int count)
+{
+    struct pollfd pfd;
+    int timeout = -1;
+    int ready;
+    int i;
+
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    while (TRUE)
+    {
+        ready = poll (&pfd, 1, timeout);
+        if (ready == -1 && errno == EINTR)
+            continue;
+        if (ready == -1)
+            return FALSE;
+        if (ready == 0)
+        {
+            for (i = 0; i < count; i++)
+            {
+                if (watched[i].changed)
+                    return TRUE;
+            }
+            /* Only other files of the directories changed. */
+            timeout = -1;
+            continue;
+        }
+        if (!read_events (fd, watched, count))
+            return FALSE;
+        timeout = WATCH_DELAY;
+    }
+}
+
+/**
+ * Updates the graph for the changed files. Files, which were removed or
+ * cannot be read or lexed anymore, are reported and left out, until they
+ * are changed again.
+ *
+ * \param graph The graph_t to update.
+ * \param watched The watched files.
+ * \param count The amount of files.
+ * \param changed Receives the changed files, which are read again.
+ * \param jobs The amount of threads to use for lexing.
+ * \param lex The lexer function to use.
+ * \param data The data to pass to the lexer function.
+ * \param cache The cache of the logs or NULL.
+ * \return TRUE on success, FALSE on error.
+ */
+static bool_t
+update_files (graph_t *graph, watched_t *watched, int count, char **changed,
+              int jobs, lex_func_t lex, void *data, const logcache_t *cache)
+{
+    int found = 0;
+    int failed = 0;
+    int i;
+
+    for (i = 0; i < count; i++)
+    {
+        if (!watched[i].changed)
+            continue;
+        watched[i].changed = FALSE;
+        changed[found++] = watched[i].file;
+    }
+    return update_graph (graph, changed, found, jobs, lex, data, cache,
+        &failed);
+}
+#endif
+
+/**
+ * Watches the input files of a graph and keeps a printed version of the
+ * graph up to date. The graph is printed to the output file first.
+ * Whenever some of the files change, only the changed files and the
+ * files after them are lexed again and updated in the graph using
+ * update_graph(), before it is printed again. The function only returns
+ * on errors.
+ *
+ * \param graph The graph_t created from the files.
+ * \param files The files to watch.
+ * \param count The amount of files.
+ * \param jobs The amount of threads to use for lexing.
+ * \param lex The lexer function to use.
+ * \param data The data to pass to the lexer function.
+ * \param cache The cache of the logs or NULL.
+ * \param print The printing function to use.
+ * \param output The name of the output file.
+ * \return FALSE on error.
+ */
+bool_t
+watch_graph (graph_t *graph, char **files, int count, int jobs,
+             lex_func_t lex, void *data, const logcache_t *cache,
+             print_func_t print, const char *output)
+{
+#ifdef HAVE_INOTIFY
+    watched_t *watched;
+    char **changed;
+    int fd;
+    int i;
+
+    watched = calloc ((size_t) count, sizeof (watched_t));
+    changed = calloc ((size_t) count, sizeof (char*));
+    if (!watched || !changed)
+    {
+        fprintf (stderr, "Memory allocation error\n");
+        free (watched);
+        free (changed);
+        return FALSE;
+    }
+    for (i = 0; i < count; i++)
+        watched[i].file = files[i];
+
+    fd = inotify_init ();
+    if (fd == -1)
+        perror (output);
+    else if (add_watches (fd, watched, count) &&
+        write_output (graph, print, output))
+    {
+        while (TRUE)
+        {
+            if (!wait_events (fd, watched, count))
+            {
+                perror (output);
+                break;
+            }
+            if (!update_files (graph, watched, count, changed, jobs, lex,
+                    data, cache) || !write_output (graph, print, output))
+                break;
+        }
+    }
+    if (fd != -1)
+        close (fd);
+    free (watched);
+    free (changed);
+    return FALSE;
+#else
+    (void) graph;
+    (void) files;
+    (void) count;
+    (void) jobs;
+    (void) lex;
+    (void) data;
+    (void) cache;
+    (void) print;
+    fprintf (stderr, "%s: Watching files is not supported\n", output);
+    return FALSE;
+#endif
+}
@@ -40,6 +40,10 @@
 #define PATH_MAX 255
 #endif
 
+#if _MSC_VER < 1900
+#define vsnprintf _vsnprintf
+#endif
+
 static int
 strcasecmp (const char *text1, const char *text2)
 {
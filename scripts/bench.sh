@@ -0,0 +1,121 @@
+#!/bin/sh
+# bench - end-to-end benchmark of cgraph and asmgraph on synthetic corpora.
+#
+# Each corpus is created once by gencorpus.sh within the work directory
+# and reused by later runs with the same parameters. Every program run
+# writes its statistics (-t), of which the best total time of all
+# repetitions is reported as throughput in MB/s and functions/s. The
+# graph is printed with -g, since the size of the default tree output
+# grows exponentially with the depth of the generated call graphs.
+
+PROGNAME=`basename $0`
+SCRIPTDIR=`dirname $0`
+bindir=.
+workdir=bench
+reps=3
+scale=1
+jobs=1
+
+usage()
+{
+    echo "usage: $PROGNAME [-b bindir] [-j jobs] [-o workdir] [-r reps]"
+    echo "                [-x scale] [corpus ...]"
+    exit 1
+}
+
+while getopts b:j:o:r:x: arg; do
+    case $arg in
+        b)
+            bindir=$OPTARG
+            ;;
+        j)
+            jobs=$OPTARG
+            ;;
+        o)
+            workdir=$OPTARG
+            ;;
+        r)
+            reps=$OPTARG
+            ;;
+        x)
+            scale=$OPTARG
+            ;;
+        *)
+            usage
+            ;;
+    esac
+done
+shift `expr $OPTIND - 1`
+
+# The corpora: name, language, files, functions per file, fan-out,
+# recursion ratio, statics ratio, line marker density and initializer
+# table entries. The amount of files is multiplied by the scale.
+corpora="
+c-small      c    100 20 4 0   0   0   0
+c-large      c    1000 50 6 0  0.2 0   0
+c-recursive  c    200 30 4 0.3 0.3 0   0
+c-markers    c    200 30 4 0   0   0.3 0
+c-tables     c    100 20 4 0   0   0   5000
+as           as   200 30 4 0.1 0.2 0   0
+nasm         nasm 200 30 4 0.1 0.2 0   0
+"
+
+mkdir -p "$workdir" || exit 1
+printf "%-12s %-5s %7s %8s %8s %9s %8s %11s\n" corpus lang files \
+    funcs MB seconds MB/s funcs/s
+
+echo "$corpora" | while read name lang files funcs fanout rec stat mark tab
+do
+    if [ -z "$name" ]; then
+        continue
+    fi
+    if [ $# -gt 0 ]; then
+        case " $* " in
+            *" $name "*)
+                ;;
+            *)
+                continue
+                ;;
+        esac
+    fi
+
+    files=`expr $files \* $scale`
+    dir="$workdir/$name-$files-$funcs-$fanout-$rec-$stat-$mark-$tab"
+    if [ ! -f "$dir/.done" ]; then
+        rm -rf "$dir"
+        sh "$SCRIPTDIR/gencorpus.sh" -l $lang -n $files -f $funcs \
+            -c $fanout -r $rec -s $stat -m $mark -t $tab -o "$dir" || exit 1
+        touch "$dir/.done"
+    fi
+
+    case $lang in
+        c)
+            prog="$bindir/cgraph"
+            ;;
+        as)
+            prog="$bindir/asmgraph -a"
+            ;;
+        nasm)
+            prog="$bindir/asmgraph -n"
+            ;;
+    esac
+
+    best=""
+    i=0
+    while [ $i -lt $reps ]; do
+        $prog -g -j $jobs -t "$workdir/stats.json" "$dir"/f* \
+            > /dev/null || exit 1
+        secs=`sed -n 's/^  "total_seconds": \(.*\),$/\1/p' \
+            "$workdir/stats.json"`
+        best=`echo "$best $secs" | awk '{
+            print ($2 == "" || ($1 != "" && $1 < $2)) ? $1 : $2 }'`
+        i=`expr $i + 1`
+    done
+
+    bytes=`cat "$dir"/f* | wc -c`
+    echo "$name $lang $files $funcs $bytes $best" | awk '{
+        mb = $5 / 1048576;
+        fn = $3 * $4;
+        printf "%-12s %-5s %7d %8d %8.2f %9.4f %8.2f %11.0f\n",
+            $1, $2, $3, fn, mb, $6, mb / $6, fn / $6 }'
+done
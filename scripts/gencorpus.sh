@@ -0,0 +1,314 @@
+#!/bin/sh
+# gencorpus - generates synthetic C, GNU as or NASM sources for benchmarks.
+#
+# The functions are numbered across all files. Calls usually go to
+# functions with a higher number, so that the call graph has no cycles,
+# while the recursion ratio sets the share of calls, which go back to a
+# function with a lower or the same number. Static functions are only
+# called within their own file. C files can get a static initializer
+# table of the given amount of entries. The same seed creates the same
+# corpus with the same awk(1) implementation.
+
+PROGNAME=`basename $0`
+lang=c
+files=100
+funcs=20
+fanout=4
+recursion=0
+statics=0
+markers=0
+tables=0
+seed=1
+outdir=""
+
+usage()
+{
+    echo "usage: $PROGNAME [-l c|as|nasm] [-n files] [-f funcs] [-c fanout]"
+    echo "                 [-r ratio] [-s ratio] [-m density] [-t entries]"
+    echo "                 [-S seed] -o dir"
+    exit 1
+}
+
+while getopts c:f:l:m:n:o:r:s:S:t: arg; do
+    case $arg in
+        c)
+            fanout=$OPTARG
+            ;;
+        f)
+            funcs=$OPTARG
+            ;;
+        l)
+            lang=$OPTARG
+            ;;
+        m)
+            markers=$OPTARG
+            ;;
+        n)
+            files=$OPTARG
+            ;;
+        o)
+            outdir=$OPTARG
+            ;;
+        r)
+            recursion=$OPTARG
+            ;;
+        s)
+            statics=$OPTARG
+            ;;
+        S)
+            seed=$OPTARG
+            ;;
+        t)
+            tables=$OPTARG
+            ;;
+        *)
+            usage
+            ;;
+    esac
+done
+
+case $lang in
+    c|as|nasm)
+        ;;
+    *)
+        usage
+        ;;
+esac
+if [ -z "$outdir" ]; then
+    usage
+fi
+mkdir -p "$outdir" || exit 1
+
+${AWK:-awk} -v lang="$lang" -v files="$files" -v funcs="$funcs" \
+    -v fanout="$fanout" -v recursion="$recursion" -v statics="$statics" \
+    -v markers="$markers" -v tables="$tables" -v seed="$seed" \
+    -v outdir="$outdir" '
+# Indicates, whether the function with the passed number is static. The
+# first function of each file is never static, so that other files can
+# call it instead.
+function is_static(g)
+{
+    if (g % funcs == 0)
+        return 0;
+    return ((g * 7919 + 13) % 1000) < statics * 1000;
+}
+
+function name(g)
+{
+    return "f" int(g / funcs) "_" (g % funcs);
+}
+
+# Chooses the function, which is called by the function g.
+function target(g,    t, back)
+{
+    back = (rand() < recursion);
+    if (!back && g + 1 >= total)
+        back = 1;
+    if (back)
+        t = int(rand() * (g + 1));
+    else
+        t = g + 1 + int(rand() * (total - g - 1));
+    if (is_static(t) && int(t / funcs) != int(g / funcs))
+        t = t - t % funcs;
+    return t;
+}
+
+# Writes a line of a C file. Line markers of fake headers are emitted
+# between the lines of the file according to the density.
+function cline(text)
+{
+    if (markers > 0 && rand() < markers)
+    {
+        hdr++;
+        print "# 1 \"include/hdr" hdr ".h\" 1" > out;
+        print "extern int hdrvar" hdr ";" > out;
+        print "# " line " \"" out "\" 2" > out;
+    }
+    print text > out;
+    line++;
+}
+
+# Writes a static initializer table of a C file, which refers to the
+# functions of the file, but does not call them.
+function write_table(file,    e)
+{
+    cline("struct ent" file " { const char *name; int (*func) (int a, " \
+        "const char *s); int args[2]; };");
+    cline("static const struct ent" file " table" file "[] = {");
+    for (e = 0; e < tables; e++)
+    {
+        cline("    { \"entry " e " {\", " \
+            name(file * funcs + e % funcs) ", { " e ", (int) " \
+            "sizeof (struct ent" file ") } }, /* } */");
+    }
+    cline("};");
+    cline("");
+}
+
+function write_c(file,    k, g, c, t, calls, ncalls, seen)
+{
+    out = outdir "/f" file ".c";
+    line = 1;
+    cline("/* Generated benchmark file " file ". */");
+    cline("#include <stdio.h>");
+    cline("");
+    cline("int gv" file " = " file ";");
+    cline("static const char *names" file "[] = " \
+        "{ \"a(b\", \"c}d\", \"\\\"\" };");
+
+    # The calls are chosen first to declare the called functions.
+    split("", seen);
+    for (k = 0; k < funcs; k++)
+    {
+        g = file * funcs + k;
+        ncalls[k] = fanout;
+        for (c = 0; c < fanout; c++)
+        {
+            t = target(g);
+            calls[k, c] = t;
+            if (int(t / funcs) != file && !(t in seen))
+            {
+                seen[t] = 1;
+                cline("extern int " name(t) " (int a, const char *s);");
+            }
+        }
+    }
+    for (k = 0; k < funcs; k++)
+    {
+        g = file * funcs + k;
+        if (is_static(g))
+            cline("static int " name(g) " (int a, const char *s);");
+        else
+            cline("int " name(g) " (int a, const char *s);");
+    }
+    cline("");
+    if (tables > 0)
+        write_table(file);
+
+    for (k = 0; k < funcs; k++)
+    {
+        g = file * funcs + k;
+        cline("/*");
+        cline(" * " name(g) " - generated function with " ncalls[k] \
+            " calls.");
+        cline(" */");
+        cline((is_static(g) ? "static int" : "int"));
+        cline(name(g) " (int a, const char *s)");
+        cline("{");
+        cline("    int x = a * 3 + 1; /* Local state. */");
+        cline("    char buf[32] = \"text with ( and ) and {\";");
+        cline("");
+        for (c = 0; c < ncalls[k]; c++)
+        {
+            if (c % 2)
+            {
+                cline("    if (x > " c " && s != NULL)");
+                cline("        x -= " name(calls[k, c]) " (x, s) + gv" \
+                    file ";");
+            }
+            else
+                cline("    x += " name(calls[k, c]) " (x, s) + gv" file ";");
+        }
+        cline("    // Not a call: g (x); \"");
+        cline("    return x + (int) buf[0] + (int) names" file "[0][0];");
+        cline("}");
+        cline("");
+    }
+    if (file == 0)
+    {
+        cline("int");
+        cline("main (void)");
+        cline("{");
+        cline("    return " name(0) " (0, \"main\");");
+        cline("}");
+    }
+    close(out);
+}
+
+function write_as(file,    k, g, c)
+{
+    out = outdir "/f" file ".s";
+    print "\t.file\t\"f" file ".c\"" > out;
+    print "\t.text" > out;
+    if (file == 0)
+    {
+        print ".globl main" > out;
+        print "\t.type\tmain, @function" > out;
+        print "main:" > out;
+        print "\tcall\t" name(0) > out;
+        print "\tret" > out;
+        print "\t.size\tmain, .-main" > out;
+    }
+    for (k = 0; k < funcs; k++)
+    {
+        g = file * funcs + k;
+        print "\t.p2align 4,,15" > out;
+        if (!is_static(g))
+            print ".globl " name(g) > out;
+        print "\t.type\t" name(g) ", @function" > out;
+        print name(g) ":" > out;
+        print "\tpushl\t%ebp" > out;
+        print "\tmovl\t%esp, %ebp" > out;
+        for (c = 0; c < fanout; c++)
+        {
+            print "\tcall\t" name(target(g)) > out;
+            print "\taddl\t$4, %esp" > out;
+        }
+        print "\tmovl\t%eax, gv" file > out;
+        print "\tleave" > out;
+        print "\tret" > out;
+        print "\t.size\t" name(g) ", .-" name(g) > out;
+    }
+    print "\t.comm\tgv" file ",4,4" > out;
+    close(out);
+}
+
+function write_nasm(file,    k, g, c)
+{
+    out = outdir "/f" file ".asm";
+    print "        section .bss" > out;
+    print "gv" file ":      resd 1" > out;
+    print "        section .text" > out;
+    print "" > out;
+    if (file == 0)
+    {
+        print "        global main" > out;
+        print "main:" > out;
+        print "        call\t" name(0) > out;
+        print "        ret" > out;
+        print "" > out;
+    }
+    for (k = 0; k < funcs; k++)
+    {
+        g = file * funcs + k;
+        if (!is_static(g))
+            print "        global " name(g) > out;
+        print name(g) ":" > out;
+        print "        push\tebp ; Keep the frame." > out;
+        print "        mov\tesp, ebp" > out;
+        for (c = 0; c < fanout; c++)
+        {
+            print "        call\t" name(target(g)) > out;
+            print "        add\tesp, 4" > out;
+        }
+        print "        mov\teax, gv" file > out;
+        print "        ret" > out;
+        print "" > out;
+    }
+    close(out);
+}
+
+BEGIN {
+    srand(seed);
+    total = files * funcs;
+    hdr = 0;
+    for (f = 0; f < files; f++)
+    {
+        if (lang == "c")
+            write_c(f);
+        else if (lang == "as")
+            write_as(f);
+        else
+            write_nasm(f);
+    }
+}'